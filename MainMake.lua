@@ -13,6 +13,12 @@ workspace "MyGame"
 		"MultiProcessorCompile"
 	}
 
+newoption
+{
+	trigger = "track-allocations",
+	description = "Attribute every heap allocation to the active profiler scope (MYGAME_TRACK_ALLOCATIONS)"
+}
+
 outputdir = "%{cfg.buildcfg}"
 defaultDirectory = "MyGame"
 
@@ -84,10 +90,14 @@ project "MyGame"
 
 	filter "configurations:Release"
 		defines "MYGAME_RELEASE"
+		defines "MYGAME_ENABLE_PROFILING"
 		defines "NDEBUG"
 		runtime "Release"
 		optimize "Speed"
 
+	filter "options:track-allocations"
+		defines "MYGAME_TRACK_ALLOCATIONS"
+
 --	filter { "files:**.hlsl" }
 --   		flags "ExcludeFromBuild"
 --   		shadermodel "6.5"
@@ -299,6 +309,70 @@ project "D3D12MemoryAlloc"
 	filter "configurations:Release"
 		runtime "Release"
 
+project "TraceConverter"
+	location "Tools"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "On"
+
+	targetdir ("%{wks.location}/Binary/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/BinaryIntermediate/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"Tools/%{prj.name}/**.h",
+		"Tools/%{prj.name}/**.cpp"
+	}
+
+	includedirs
+	{
+		"" .. defaultDirectory .. "/Source"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		optimize "Speed"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+
+project "TraceCompare"
+	location "Tools"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "On"
+
+	targetdir ("%{wks.location}/Binary/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/BinaryIntermediate/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"Tools/%{prj.name}/**.h",
+		"Tools/%{prj.name}/**.cpp"
+	}
+
+	includedirs
+	{
+		"" .. defaultDirectory .. "/Source"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		optimize "Speed"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+
 group "Dependencies"
 	includedirs "MyGame/Vendor/Box2D"
 	includedirs "MyGame/Vendor/GLFW"
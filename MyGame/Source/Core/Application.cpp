@@ -2,21 +2,142 @@
 
 #include "Application.h"
 #include "Log.h"
+#include "Input.h"
 
 #include "../Renderer/Renderer.h"
 #include "../Events/AppEvent.h"
 
 #include "../Debugs/DebugHelpers.h"
 #include "../Debugs/Instrumentor.h"
+#include "../Debugs/InputLatency.h"
+
+#include <charconv>
+#include <cmath>
 
 namespace MyGame
 {
-	void Application::Init()
+	// Parses the whole of text as a number, without the exceptions of std::stoi and friends
+	template<typename T>
+	static bool ParseNumber(std::string_view text, T& value)
 	{
+		const char* end = text.data() + text.size();
+		auto [last, error] = std::from_chars(text.data(), end, value);
+		return error == std::errc() && last == end;
+	}
+
+	void Application::Init(ApplicationCommandLineArgs args)
+	{
+		MYGAME_PROFILE_THREAD("Main");
+
+		// --profile[=<path>] records a session from startup until exit or until F11 is pressed
+		// --profile-stats[=<path>] only collects per-scope latency statistics into a CSV, for soak tests
+		// --profile-sampling[=<us>] also samples call stacks during trace sessions, every 1000 us by default
+		// --profile-counters reads the hardware counters around MYGAME_PROFILE_SCOPE_COUNTERS sites
+		// --hitch-capture[=<ms>] keeps the last frames in memory and dumps them on slow frames
+		// --record-events[=<path>] writes the window's raw events and the frame timesteps to a file
+		// --replay=<path> runs a recording without a window or renderer, for repeatable benchmarks
+		// --tick-rate=<hz> sets the rate of the fixed simulation step, 60 by default
+		for (int i = 1; i < args.Count; i++)
+		{
+			std::string_view arg = args[i];
+			if (arg.starts_with("--profile-stats"))
+			{
+				std::string path = "MyGame_stats.csv";
+				if (arg.starts_with("--profile-stats="))
+					path = arg.substr(std::string_view("--profile-stats=").size());
+				MYGAME_PROFILE_BEGIN_STATISTICS_SESSION("Statistics", path);
+			}
+			else if (arg.starts_with("--profile-sampling"))
+			{
+				int interval = 1000;
+				if (arg.starts_with("--profile-sampling="))
+				{
+					std::string_view value = arg.substr(std::string_view("--profile-sampling=").size());
+					if (!ParseNumber(value, interval) || interval <= 0)
+					{
+						MYGAME_ERROR("--profile-sampling expects a positive number of microseconds, got '{0}'", value);
+						continue;
+					}
+					if (interval < SamplingProfiler::MinInterval.count())
+					{
+						MYGAME_WARN("Sampling every {0} us is too often, sampling every {1} us instead", interval, SamplingProfiler::MinInterval.count());
+						interval = (int)SamplingProfiler::MinInterval.count();
+					}
+				}
+				MYGAME_PROFILE_SET_SAMPLING_INTERVAL(std::chrono::microseconds(interval));
+			}
+			else if (arg == "--profile-counters")
+			{
+				MYGAME_PROFILE_SET_PERF_COUNTERS(true);
+			}
+			else if (arg.starts_with("--profile"))
+			{
+				if (arg.starts_with("--profile="))
+					m_ProfilePath = arg.substr(std::string_view("--profile=").size());
+				MYGAME_PROFILE_BEGIN_SESSION("Runtime", m_ProfilePath);
+			}
+			else if (arg.starts_with("--hitch-capture"))
+			{
+				HitchCaptureSettings settings;
+				if (arg.starts_with("--hitch-capture="))
+				{
+					std::string_view value = arg.substr(std::string_view("--hitch-capture=").size());
+					float thresholdMs = 0.0f;
+					if (!ParseNumber(value, thresholdMs) || !std::isfinite(thresholdMs) || thresholdMs <= 0.0f)
+					{
+						MYGAME_ERROR("--hitch-capture expects a positive number of milliseconds, got '{0}'", value);
+						continue;
+					}
+					settings.ThresholdMs = thresholdMs;
+				}
+				MYGAME_PROFILE_BEGIN_HITCH_CAPTURE(settings);
+			}
+			else if (arg.starts_with("--record-events"))
+			{
+				std::string path = "MyGame.mgevents";
+				if (arg.starts_with("--record-events="))
+					path = arg.substr(std::string_view("--record-events=").size());
+				m_Recorder = std::make_unique<EventRecorder>();
+				if (!m_Recorder->Open(path))
+				{
+					MYGAME_ERROR("Could not open {0} to record events", path);
+					m_Recorder.reset();
+				}
+			}
+			else if (arg.starts_with("--tick-rate="))
+			{
+				std::string_view value = arg.substr(std::string_view("--tick-rate=").size());
+				float ticksPerSecond = 0.0f;
+				if (!ParseNumber(value, ticksPerSecond) || !std::isfinite(ticksPerSecond) || ticksPerSecond <= 0.0f)
+				{
+					MYGAME_ERROR("--tick-rate expects a positive number of ticks per second, got '{0}'", value);
+					continue;
+				}
+				SetFixedTickRate(ticksPerSecond);
+			}
+			else if (arg.starts_with("--replay="))
+			{
+				std::string path(arg.substr(std::string_view("--replay=").size()));
+				m_Replay = std::make_unique<EventReplay>();
+				if (!m_Replay->Open(path))
+				{
+					MYGAME_ERROR("{0} is not an event recording of this build", path);
+					m_Replay.reset();
+				}
+			}
+		}
+
 		MYGAME_PROFILE_FUNCTION();
 
+		if (m_Replay)
+		{
+			MYGAME_INFO("Replaying events without a window");
+			return;
+		}
+
 		m_Window = Window::Create(WindowProps());
 		m_Window->SetEventCallback(MYGAME_BIND_EVENT_FN(Application::OnEvent));
+		m_Window->SetEventRecorder(m_Recorder.get());
 
 		Renderer::Init();
 
@@ -26,9 +147,18 @@ namespace MyGame
 
 	void Application::Destroy()
 	{
-		MYGAME_PROFILE_FUNCTION();
+		{
+			MYGAME_PROFILE_FUNCTION();
+
+			//Renderer::Shutdown();
+		}
 
-		//Renderer::Shutdown();
+		if (m_Recorder)
+			MYGAME_INFO("Recorded the events of {0} frames", m_Recorder->GetFrameCount());
+		m_Recorder.reset();
+
+		MYGAME_PROFILE_END_SESSION();
+		MYGAME_PROFILE_END_HITCH_CAPTURE();
 	}
 
 	void Application::PushLayer(Layer* layer)
@@ -50,14 +180,22 @@ namespace MyGame
 	void Application::OnEvent(Event& e)
 	{
 		MYGAME_PROFILE_FUNCTION();
+		MYGAME_ALLOCATION_TAG("Events");
 
 		MYGAME_INFO_EVENTS(e);
+		m_EventsDispatched++;
+
+		// Before the layers, a layer handling the event doesn't hide it from the input state
+		Input::OnEvent(ToEventValue(e));
 
 		EventDispatcher dispatcher(e);
 		dispatcher.Dispatch<WindowCloseEvent>(MYGAME_BIND_EVENT_FN(Application::OnWindowClose));
 		dispatcher.Dispatch<WindowResizeEvent>(MYGAME_BIND_EVENT_FN(Application::OnWindowResize));
+		dispatcher.Dispatch<KeyPressedEvent>(MYGAME_BIND_EVENT_FN(Application::OnKeyPressed));
 
-		for (auto it = m_LayerStack.end(); --it != m_LayerStack.begin();)
+		// Top to bottom, only through the layers subscribed to the event
+		const std::vector<Layer*>& route = m_LayerStack.GetEventRoute(e);
+		for (auto it = route.rbegin(); it != route.rend(); ++it)
 		{
 			if (e.Handled)
 				break;
@@ -71,25 +209,105 @@ namespace MyGame
 
 		while (m_Running)
 		{
-			float time = (float)glfwGetTime();
-			Timestep timestep = time - m_LastFrameTime;
-			m_LastFrameTime = time;
+			MYGAME_PROFILE_FRAME_MARK();
+			MYGAME_PROFILE_COUNTER("Events dispatched", m_EventsDispatched);
+			MYGAME_PROFILE_COUNTER("Layers", m_LayerStack.size());
+			m_EventsDispatched = 0;
+
+			Timestep timestep;
+			if (m_Replay)
+			{
+				// The recorded frames stand in for the clock, every replay sees the same timesteps and events
+				if (!m_Replay->ReadFrame(m_ReplayEvents))
+				{
+					MYGAME_INFO("Replayed {0} frames", m_Replay->GetFramesRead());
+					break;
+				}
+				timestep = m_Replay->GetTimestep();
+			}
+			else
+			{
+				float time = (float)glfwGetTime();
+				timestep = time - m_LastFrameTime;
+				m_LastFrameTime = time;
+			}
 
 			if (!m_Minimized)
 			{
+				// Simulation first, so the variable update and rendering see the newest state
+				FixedUpdate(timestep);
+
 				for (Layer* layer : m_LayerStack)
 					layer->OnUpdate(timestep);
 
-				m_ImGuiLayer->Begin();
-				for (Layer* layer : m_LayerStack)
-					layer->OnImGuiRender();
-				m_ImGuiLayer->End();
+				if (m_ImGuiLayer)
+				{
+					MYGAME_ALLOCATION_TAG("ImGui");
+					m_ImGuiLayer->Begin();
+					for (Layer* layer : m_LayerStack)
+						layer->OnImGuiRender();
+					m_ImGuiLayer->End();
+				}
 			}
 
+			if (m_Replay)
+			{
+				m_PostedEvents.Drain([this](const EventValue& event) { m_ReplayEvents.Push(event); });
+				m_ReplayEvents.Dispatch(MYGAME_BIND_EVENT_FN(Application::OnEvent));
+				Input::EndFrame();
+				continue;
+			}
+
+			// Input and window events arrive during the poll and are handled here in one batch with the
+			// events other threads posted, so the layers see them in order and outside of the OS message pump
 			m_Window->OnUpdate();
+			m_PostedEvents.Drain([this](const EventValue& event) { m_Window->GetEventQueue().Push(event); });
+			if (const uint64_t dropped = m_PostedEvents.TakeDropped())
+				MYGAME_WARN("{0} posted events were dropped, the channel was full", dropped);
+			if (m_Recorder)
+				m_Recorder->EndFrame(timestep);
+			m_Window->DispatchEvents();
+			InputLatency::OnInputConsumed();
+			Input::EndFrame();
 		}
 	}
 
+	void Application::SetFixedTickRate(float ticksPerSecond)
+	{
+		MYGAME_ASSERT(std::isfinite(ticksPerSecond) && ticksPerSecond > 0.0f, "The fixed tick rate must be positive");
+		m_FixedTimestep = 1.0 / ticksPerSecond;
+	}
+
+	void Application::SetMaxFixedSteps(int steps)
+	{
+		MYGAME_ASSERT(steps > 0, "At least one fixed step has to run per frame");
+		m_MaxFixedSteps = steps;
+	}
+
+	void Application::FixedUpdate(Timestep timestep)
+	{
+		MYGAME_PROFILE_FUNCTION();
+
+		m_FixedAccumulator += timestep.GetSeconds();
+
+		int steps = 0;
+		while (m_FixedAccumulator >= m_FixedTimestep && steps < m_MaxFixedSteps)
+		{
+			for (Layer* layer : m_LayerStack)
+				layer->OnFixedUpdate((float)m_FixedTimestep);
+			m_FixedAccumulator -= m_FixedTimestep;
+			steps++;
+		}
+
+		// Past the catch-up limit the simulation runs slower than real time instead of stalling,
+		// only the fraction of a tick is kept for the interpolation
+		if (m_FixedAccumulator >= m_FixedTimestep)
+			m_FixedAccumulator = std::fmod(m_FixedAccumulator, m_FixedTimestep);
+
+		m_InterpolationAlpha = (float)(m_FixedAccumulator / m_FixedTimestep);
+		MYGAME_PROFILE_COUNTER("Fixed steps", steps);
+	}
+
 	bool Application::OnWindowClose(WindowCloseEvent& e)
 	{
 		m_Running = false;
@@ -107,23 +325,38 @@ namespace MyGame
 		}
 
 		m_Minimized = false;
+		// A replay runs without a renderer, so there is no swap chain to resize
+		if (m_Replay)
+			return false;
+
 		Renderer::OnWindowResize(e.GetWidth(), e.GetHeight());
 
 		return false;
 	}
 
+	bool Application::OnKeyPressed(KeyPressedEvent& e)
+	{
+		if (e.GetKeyCode() == Key::F11 && !e.IsRepeat())
+		{
+			MYGAME_PROFILE_TOGGLE_SESSION("Runtime", m_ProfilePath);
+			return true;
+		}
+
+		return false;
+	}
+
 	void Application::Close() { m_Running = false; }
 
 	Application application;
 }
 
-int main()
+int main(int argc, char** argv)
 {
 	MyGame::Log::Init();
 	MYGAME_INFO("Welcome to MyGame!");
 
 	// Application lifetime
-	MyGame::application.Init();
+	MyGame::application.Init({ argc, argv });
 	MyGame::application.Run();
 	MyGame::application.Destroy();
 
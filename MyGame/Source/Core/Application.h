@@ -7,24 +7,47 @@
 #include "LayerStack.h"
 #include "../Layers/ImGui/ImGuiLayer.h"
 
+// Events
+#include "../Events/KeyEvent.h"
+#include "../Events/EventChannel.h"
+
 #include "Base.h"
 
 namespace MyGame
 {
+	struct ApplicationCommandLineArgs
+	{
+		int Count = 0;
+		char** Args = nullptr;
+
+		const char* operator[](int index) const { return Args[index]; }
+	};
+
 	class Application
 	{
 	public:
-		void Init();
+		void Init(ApplicationCommandLineArgs args = ApplicationCommandLineArgs());
 		void Destroy();
 
 		void Run();
 		void Close();
 
 		void OnEvent(Event&);
+		// Thread safe and lock free, the event goes through OnEvent with the window's events of the next
+		// dispatch. False when too many events are pending and it was dropped.
+		bool PostEvent(const EventValue& event) { return m_PostedEvents.Post(event); }
 		void PushLayer(Layer* layer);
 		void PushOverlay(Layer* layer);
 		ImGuiLayer* GetImGuiLayer() { return m_ImGuiLayer; }
 
+		// Rate of Layer::OnFixedUpdate, and how many ticks a slow frame may catch up before the rest
+		// of its time is dropped, so a hitch can't snowball into ever longer frames
+		void SetFixedTickRate(float ticksPerSecond);
+		void SetMaxFixedSteps(int steps);
+		float GetFixedTimestep() const { return (float)m_FixedTimestep; }
+		// How far the frame is between the last tick and the next one, from 0 to 1
+		float GetInterpolationAlpha() const { return m_InterpolationAlpha; }
+
 		Window& GetWindow() { return *m_Window; }
 		GLFWwindow* GetNativeWindow() const { return m_Window->GetWindow(); }
 		HWND GetWin32Window() const { return glfwGetWin32Window(m_Window->GetWindow()); }
@@ -32,14 +55,35 @@ namespace MyGame
 	private:
 		bool OnWindowClose(WindowCloseEvent&);
 		bool OnWindowResize(WindowResizeEvent&);
+		bool OnKeyPressed(KeyPressedEvent&);
+
+		void FixedUpdate(Timestep timestep);
 
 	private:
 		std::unique_ptr<Window> m_Window;
 
-		ImGuiLayer* m_ImGuiLayer;
+		ImGuiLayer* m_ImGuiLayer = nullptr;
 		LayerStack m_LayerStack;
+		EventChannel m_PostedEvents;
+
+		// --record-events and --replay, a replay runs without window, renderer and ImGui
+		std::unique_ptr<EventRecorder> m_Recorder;
+		std::unique_ptr<EventReplay> m_Replay;
+		EventQueue m_ReplayEvents;
+
+		// Written by --profile=<path> or toggled with F11, works in Release builds too
+		std::string m_ProfilePath = "MyGame.mgtrace";
+
+		// Per frame, reported as a profiler counter
+		uint32_t m_EventsDispatched = 0;
 
 		float m_LastFrameTime = 0.0f;
+
+		double m_FixedTimestep = 1.0 / 60.0;
+		double m_FixedAccumulator = 0.0;
+		int m_MaxFixedSteps = 5;
+		float m_InterpolationAlpha = 0.0f;
+
 		bool m_Running = true;
 		bool m_Minimized = false;
 	};
@@ -1,35 +1,173 @@
 #include "CommonHeaders.h"
 
 #include "Input.h"
-#include "Application.h"
 
-#include <GLFW/glfw3.h>
+#include <atomic>
 
 namespace MyGame
 {
-	bool Input::IsKeyPressed(const int key)
+	static constexpr int s_KeyCount = 512; // GLFW_KEY_LAST is 348
+	static constexpr int s_KeyWords = s_KeyCount / 64;
+	static constexpr int s_ButtonCount = Mouse::ButtonLast + 1;
+
+	// Written by the main thread only
+	struct InputFrame
+	{
+		std::array<uint64_t, s_KeyWords> KeysDown = {}, KeysPressed = {}, KeysReleased = {};
+		uint32_t ButtonsDown = 0, ButtonsPressed = 0, ButtonsReleased = 0;
+		bool HasCursor = false;
+		float MouseX = 0.0f, MouseY = 0.0f;
+		float DeltaX = 0.0f, DeltaY = 0.0f;
+		float ScrollX = 0.0f, ScrollY = 0.0f;
+	};
+
+	// Published copy of an InputFrame. Fields are atomics only so readers on other threads don't race
+	// the main thread, a snapshot stays consistent unless a read spans two EndFrame calls.
+	struct InputSnapshot
+	{
+		std::array<std::atomic<uint64_t>, s_KeyWords> KeysDown, KeysPressed, KeysReleased;
+		std::atomic<uint32_t> ButtonsDown, ButtonsPressed, ButtonsReleased;
+		std::atomic<float> MouseX, MouseY;
+		std::atomic<float> DeltaX, DeltaY;
+		std::atomic<float> ScrollX, ScrollY;
+	};
+
+	static InputFrame s_Frame;
+	static InputSnapshot s_Snapshots[2];
+	static std::atomic<int> s_Published = 0;
+
+	static const InputSnapshot& GetSnapshot() { return s_Snapshots[s_Published.load(std::memory_order_acquire)]; }
+
+	static bool TestKey(const std::array<std::atomic<uint64_t>, s_KeyWords>& words, int key)
 	{
-		auto* window = application.GetWindow().GetWindow();
-		auto state = glfwGetKey(window, key);
-		return state == GLFW_PRESS;
+		if (key < 0 || key >= s_KeyCount)
+			return false;
+		return (words[key / 64].load(std::memory_order_relaxed) >> (key % 64)) & 1;
 	}
 
-	bool Input::IsMouseButtonPressed(const int button)
+	static bool TestButton(const std::atomic<uint32_t>& buttons, int button)
 	{
-		auto* window = application.GetWindow().GetWindow();
-		auto state = glfwGetMouseButton(window, button);
-		return state == GLFW_PRESS;
+		if (button < 0 || button >= s_ButtonCount)
+			return false;
+		return (buttons.load(std::memory_order_relaxed) >> button) & 1;
 	}
 
-	DirectX::XMFLOAT2 Input::GetMousePosition()
+	static void StoreKeys(std::array<std::atomic<uint64_t>, s_KeyWords>& words, const std::array<uint64_t, s_KeyWords>& keys)
 	{
-		auto* window = application.GetWindow().GetWindow();
-		double xpos, ypos;
-		glfwGetCursorPos(window, &xpos, &ypos);
+		for (int word = 0; word < s_KeyWords; word++)
+			words[word].store(keys[word], std::memory_order_relaxed);
+	}
+
+	static void SetKey(std::array<uint64_t, s_KeyWords>& words, int key) { words[key / 64] |= 1ull << (key % 64); }
+	static void ResetKey(std::array<uint64_t, s_KeyWords>& words, int key) { words[key / 64] &= ~(1ull << (key % 64)); }
+
+	bool Input::IsKeyPressed(const int key) { return TestKey(GetSnapshot().KeysDown, key); }
+	bool Input::IsMouseButtonPressed(const int button) { return TestButton(GetSnapshot().ButtonsDown, button); }
 
-		return { (float)xpos, (float)ypos };
+	bool Input::WasKeyPressed(const int key) { return TestKey(GetSnapshot().KeysPressed, key); }
+	bool Input::WasKeyReleased(const int key) { return TestKey(GetSnapshot().KeysReleased, key); }
+	bool Input::WasMouseButtonPressed(const int button) { return TestButton(GetSnapshot().ButtonsPressed, button); }
+	bool Input::WasMouseButtonReleased(const int button) { return TestButton(GetSnapshot().ButtonsReleased, button); }
+
+	DirectX::XMFLOAT2 Input::GetMousePosition()
+	{
+		const InputSnapshot& snapshot = GetSnapshot();
+		return { snapshot.MouseX.load(std::memory_order_relaxed), snapshot.MouseY.load(std::memory_order_relaxed) };
 	}
 
 	float Input::GetMouseX() { return GetMousePosition().x; }
 	float Input::GetMouseY() { return GetMousePosition().y; }
-}
\ No newline at end of file
+
+	DirectX::XMFLOAT2 Input::GetMouseDelta()
+	{
+		const InputSnapshot& snapshot = GetSnapshot();
+		return { snapshot.DeltaX.load(std::memory_order_relaxed), snapshot.DeltaY.load(std::memory_order_relaxed) };
+	}
+
+	DirectX::XMFLOAT2 Input::GetScrollDelta()
+	{
+		const InputSnapshot& snapshot = GetSnapshot();
+		return { snapshot.ScrollX.load(std::memory_order_relaxed), snapshot.ScrollY.load(std::memory_order_relaxed) };
+	}
+
+	void Input::OnEvent(const EventValue& event)
+	{
+		switch (event.Type)
+		{
+		case EventType::KeyPressed:
+			if (event.Key.KeyCode >= 0 && event.Key.KeyCode < s_KeyCount && !event.Key.IsRepeat)
+			{
+				SetKey(s_Frame.KeysDown, event.Key.KeyCode);
+				SetKey(s_Frame.KeysPressed, event.Key.KeyCode);
+			}
+			break;
+		case EventType::KeyReleased:
+			if (event.Key.KeyCode >= 0 && event.Key.KeyCode < s_KeyCount)
+			{
+				ResetKey(s_Frame.KeysDown, event.Key.KeyCode);
+				SetKey(s_Frame.KeysReleased, event.Key.KeyCode);
+			}
+			break;
+		case EventType::MouseButtonPressed:
+			if (event.Button.Button >= 0 && event.Button.Button < s_ButtonCount)
+			{
+				s_Frame.ButtonsDown |= 1u << event.Button.Button;
+				s_Frame.ButtonsPressed |= 1u << event.Button.Button;
+			}
+			break;
+		case EventType::MouseButtonReleased:
+			if (event.Button.Button >= 0 && event.Button.Button < s_ButtonCount)
+			{
+				s_Frame.ButtonsDown &= ~(1u << event.Button.Button);
+				s_Frame.ButtonsReleased |= 1u << event.Button.Button;
+			}
+			break;
+		case EventType::MouseMoved:
+			// The first position has nothing to be a delta from
+			if (s_Frame.HasCursor)
+			{
+				s_Frame.DeltaX += event.Cursor.X - s_Frame.MouseX;
+				s_Frame.DeltaY += event.Cursor.Y - s_Frame.MouseY;
+			}
+			s_Frame.HasCursor = true;
+			s_Frame.MouseX = event.Cursor.X;
+			s_Frame.MouseY = event.Cursor.Y;
+			break;
+		case EventType::MouseScrolled:
+			s_Frame.ScrollX += event.Scroll.XOffset;
+			s_Frame.ScrollY += event.Scroll.YOffset;
+			break;
+		default:
+			break;
+		}
+	}
+
+	void Input::EndFrame()
+	{
+		// Readers are on the published snapshot, the other one is free to overwrite
+		const int next = 1 - s_Published.load(std::memory_order_relaxed);
+		InputSnapshot& snapshot = s_Snapshots[next];
+
+		StoreKeys(snapshot.KeysDown, s_Frame.KeysDown);
+		StoreKeys(snapshot.KeysPressed, s_Frame.KeysPressed);
+		StoreKeys(snapshot.KeysReleased, s_Frame.KeysReleased);
+		snapshot.ButtonsDown.store(s_Frame.ButtonsDown, std::memory_order_relaxed);
+		snapshot.ButtonsPressed.store(s_Frame.ButtonsPressed, std::memory_order_relaxed);
+		snapshot.ButtonsReleased.store(s_Frame.ButtonsReleased, std::memory_order_relaxed);
+		snapshot.MouseX.store(s_Frame.MouseX, std::memory_order_relaxed);
+		snapshot.MouseY.store(s_Frame.MouseY, std::memory_order_relaxed);
+		snapshot.DeltaX.store(s_Frame.DeltaX, std::memory_order_relaxed);
+		snapshot.DeltaY.store(s_Frame.DeltaY, std::memory_order_relaxed);
+		snapshot.ScrollX.store(s_Frame.ScrollX, std::memory_order_relaxed);
+		snapshot.ScrollY.store(s_Frame.ScrollY, std::memory_order_relaxed);
+		s_Published.store(next, std::memory_order_release);
+
+		// Edges and deltas start over, held keys and the position carry into the next frame
+		s_Frame.KeysPressed = {};
+		s_Frame.KeysReleased = {};
+		s_Frame.ButtonsPressed = 0;
+		s_Frame.ButtonsReleased = 0;
+		s_Frame.DeltaX = s_Frame.DeltaY = 0.0f;
+		s_Frame.ScrollX = s_Frame.ScrollY = 0.0f;
+	}
+}
@@ -2,19 +2,38 @@
 
 #include "../Events/EventCodes/KeyCodes.h"
 #include "../Events/EventCodes/MouseCodes.h"
+#include "../Events/EventValue.h"
 
 #include <DirectXMath.h>
 
 namespace MyGame
 {
+	// Snapshot of the keyboard and mouse taken once per frame from the dispatched events.
+	// Queries are reads of the published snapshot, they never reach GLFW and are safe from any
+	// thread. Headless replays fill it from the recording like a live window does.
 	class Input
 	{
 	public:
 		static bool IsKeyPressed(const int);
 		static bool IsMouseButtonPressed(const int);
 
+		// Edges of the last frame, also set when a key went down and up again within the frame
+		static bool WasKeyPressed(const int);
+		static bool WasKeyReleased(const int);
+		static bool WasMouseButtonPressed(const int);
+		static bool WasMouseButtonReleased(const int);
+
 		static DirectX::XMFLOAT2 GetMousePosition();
 		static float GetMouseX();
 		static float GetMouseY();
+
+		// Accumulated over the last frame
+		static DirectX::XMFLOAT2 GetMouseDelta();
+		static DirectX::XMFLOAT2 GetScrollDelta();
+
+		// Main thread: every dispatched event goes through OnEvent, EndFrame publishes the new
+		// snapshot once the frame's events are dispatched
+		static void OnEvent(const EventValue& event);
+		static void EndFrame();
 	};
 }
@@ -13,13 +13,35 @@ namespace MyGame
 
 		virtual void OnAttach() {}
 		virtual void OnDetach() {}
+		// Once per frame with the frame's time, for rendering and anything that follows the frame rate
 		virtual void OnUpdate(Timestep ts) {}
+		// Zero or more times per frame with the fixed tick of the Application, for physics and gameplay.
+		// Rendering interpolates between the last two ticks with Application::GetInterpolationAlpha.
+		virtual void OnFixedUpdate(Timestep ts) {}
 		virtual void OnEvent(Event& event) {}
 		virtual void OnImGuiRender() {}
 
 		const std::string& GetName() const { return m_DebugName; }
 
+		bool IsSubscribed(EventType type, int categories) const
+		{
+			return m_ReceivesAllEvents || (m_EventTypes & (1u << (int)type)) || (m_EventCategories & categories);
+		}
+
+	protected:
+		// Restrict OnEvent to the subscribed types and categories, a layer that never subscribes receives
+		// every event and Subscribe(EventCategory::None) receives none. Called from the constructor:
+		// pushing or popping a layer invalidates the LayerStack's routes, and the route of each event
+		// type is rebuilt on its first dispatch after that.
+		void Subscribe(EventType type) { m_ReceivesAllEvents = false; m_EventTypes |= 1u << (int)type; }
+		void Subscribe(int categories) { m_ReceivesAllEvents = false; m_EventCategories |= categories; }
+
 	protected:
 		std::string m_DebugName;
+
+	private:
+		bool m_ReceivesAllEvents = true;
+		uint32_t m_EventTypes = 0;
+		int m_EventCategories = 0;
 	};
 }
\ No newline at end of file
@@ -18,11 +18,13 @@ namespace MyGame
 	{
 		m_Layers.emplace(m_Layers.begin() + m_LayerInsertIndex, layer);
 		m_LayerInsertIndex++;
+		InvalidateRoutes();
 	}
 
 	void LayerStack::PushOverlay(Layer* overlay)
 	{
 		m_Layers.emplace_back(overlay);
+		InvalidateRoutes();
 	}
 
 	void LayerStack::PopLayer(Layer* layer)
@@ -33,6 +35,7 @@ namespace MyGame
 			layer->OnDetach();
 			m_Layers.erase(it);
 			m_LayerInsertIndex--;
+			InvalidateRoutes();
 		}
 	}
 
@@ -43,6 +46,22 @@ namespace MyGame
 		{
 			overlay->OnDetach();
 			m_Layers.erase(it);
+			InvalidateRoutes();
 		}
 	}
+
+	const std::vector<Layer*>& LayerStack::GetEventRoute(const Event& event)
+	{
+		// The categories of a type are the same for all its events, so routes are per type
+		const int type = (int)event.GetEventType();
+		if (!m_RouteBuilt[type])
+		{
+			m_Routes[type].clear();
+			for (Layer* layer : m_Layers)
+				if (layer->IsSubscribed(event.GetEventType(), event.GetCategoryFlags()))
+					m_Routes[type].push_back(layer);
+			m_RouteBuilt[type] = true;
+		}
+		return m_Routes[type];
+	}
 }
\ No newline at end of file
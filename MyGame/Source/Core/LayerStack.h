@@ -2,6 +2,7 @@
 
 #include "../Core/Layer.h"
 
+#include <array>
 #include <vector>
 
 namespace MyGame
@@ -17,6 +18,11 @@ namespace MyGame
 		void PopLayer(Layer*);
 		void PopOverlay(Layer*);
 
+		size_t size() const { return m_Layers.size(); }
+
+		// Layers subscribed to the event, bottom to top, built the first time the type is dispatched
+		const std::vector<Layer*>& GetEventRoute(const Event& event);
+
 		std::vector<Layer*>::iterator begin() { return m_Layers.begin(); }
 		std::vector<Layer*>::iterator end() { return m_Layers.end(); }
 		std::vector<Layer*>::reverse_iterator rbegin() { return m_Layers.rbegin(); }
@@ -27,8 +33,14 @@ namespace MyGame
 		std::vector<Layer*>::const_reverse_iterator rbegin() const { return m_Layers.rbegin(); }
 		std::vector<Layer*>::const_reverse_iterator rend() const { return m_Layers.rend(); }
 
+	private:
+		void InvalidateRoutes() { m_RouteBuilt.fill(false); }
+
 	private:
 		std::vector<Layer*> m_Layers;
 		unsigned int m_LayerInsertIndex = 0;
+
+		std::array<std::vector<Layer*>, EventTypeCount> m_Routes;
+		std::array<bool, EventTypeCount> m_RouteBuilt = {};
 	};
 }
\ No newline at end of file
@@ -2,16 +2,37 @@
 
 #include "Log.h"
 
+#include "../Debugs/ProfiledMutex.h"
+
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 namespace MyGame
 {
 	std::shared_ptr<spdlog::logger> Log::s_Logger;
 
+	// Lock of the console sink, every log call from every thread goes through it
+	struct LogConsoleMutex
+	{
+		using mutex_t = ProfiledMutex;
+
+		static mutex_t& mutex()
+		{
+			static mutex_t s_Mutex{ MYGAME_LOCK_SITE("Log console") };
+			return s_Mutex;
+		}
+	};
+
+#ifdef _WIN32
+	using ConsoleSink = spdlog::sinks::wincolor_stdout_sink<LogConsoleMutex>;
+#else
+	using ConsoleSink = spdlog::sinks::ansicolor_stdout_sink<LogConsoleMutex>;
+#endif
+
 	void Log::Init()
 	{
 		spdlog::set_pattern("%^[%T] %n: %v%$");
-		s_Logger = spdlog::stdout_color_mt("MyGame");
+		s_Logger = std::make_shared<spdlog::logger>("MyGame", std::make_shared<ConsoleSink>());
+		spdlog::initialize_logger(s_Logger);
 		s_Logger->set_level(spdlog::level::trace);
 	}
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 
 #include "../Debugs/DebugHelpers.h"
 #include "../Debugs/Instrumentor.h"
+#include "../Debugs/InputLatency.h"
 
 namespace MyGame
 {
@@ -49,23 +50,20 @@ namespace MyGame
 				data.Width = width;
 				data.Height = height;
 
-				WindowResizeEvent event(width, height);
-				data.EventCallback(event);
+				data.Queue(EventValue::WindowResize(width, height));
 			});
 
 		glfwSetWindowCloseCallback(m_Window, [](GLFWwindow* window)
 			{
 				WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
-				WindowCloseEvent event;
-				data.EventCallback(event);
+				data.Queue(EventValue::WindowClose());
 			});
 
 		glfwSetCursorPosCallback(m_Window, [](GLFWwindow* window, double xPos, double yPos)
 			{
 				WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-				MouseMovedEvent event((float)xPos, (float)yPos);
-				data.EventCallback(event); });
+				data.Queue(EventValue::MouseMoved((float)xPos, (float)yPos)); });
 
 		glfwSetMouseButtonCallback(m_Window, [](GLFWwindow* window, int button, int action, int mods)
 			{
@@ -75,14 +73,12 @@ namespace MyGame
 				{
 				case GLFW_PRESS:
 				{
-					MouseButtonPressedEvent event(button);
-					data.EventCallback(event);
+					data.Queue(EventValue::MouseButtonPressed(button));
 					break;
 				}
 				case GLFW_RELEASE:
 				{
-					MouseButtonReleasedEvent event(button);
-					data.EventCallback(event);
+					data.Queue(EventValue::MouseButtonReleased(button));
 					break;
 				}
 				}});
@@ -92,8 +88,7 @@ namespace MyGame
 			{
 				WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-				MouseScrolledEvent event((float)xOffset, (float)yOffset);
-				data.EventCallback(event); });
+				data.Queue(EventValue::MouseScrolled((float)xOffset, (float)yOffset)); });
 
 		glfwSetKeyCallback(m_Window, [](GLFWwindow* window, int key, int scancode, int action, int mods)
 			{
@@ -103,20 +98,17 @@ namespace MyGame
 				{
 				case GLFW_PRESS:
 				{
-					KeyPressedEvent event(key, false);
-					data.EventCallback(event);
+					data.Queue(EventValue::KeyPressed(key, false));
 					break;
 				}
 				case GLFW_RELEASE:
 				{
-					KeyReleasedEvent event(key);
-					data.EventCallback(event);
+					data.Queue(EventValue::KeyReleased(key));
 					break;
 				}
 				case GLFW_REPEAT:
 				{
-					KeyPressedEvent event(key, true);
-					data.EventCallback(event);
+					data.Queue(EventValue::KeyPressed(key, true));
 					break;
 				}
 				}});
@@ -125,8 +117,7 @@ namespace MyGame
 			{
 				WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
 
-				KeyTypedEvent event(keycode);
-				data.EventCallback(event); });
+				data.Queue(EventValue::KeyTyped(keycode)); });
 	}
 
 
@@ -143,6 +134,23 @@ namespace MyGame
 		//m_Context->SwapBuffers();
 	}
 
+	void Window::WindowData::Queue(const EventValue& event)
+	{
+		if (event.IsInCategory(EventCategoryInput))
+			InputLatency::OnInput();
+		if (Recorder)
+			Recorder->Record(event);
+		Events.Push(event);
+	}
+
+	void Window::DispatchEvents()
+	{
+		MYGAME_PROFILE_FUNCTION();
+		MYGAME_PROFILE_COUNTER("Events coalesced", m_Data.Events.GetCoalescedCount());
+
+		m_Data.Events.Dispatch(m_Data.EventCallback);
+	}
+
 	void Window::SetVSync(bool enabled)
 	{
 		if (enabled)
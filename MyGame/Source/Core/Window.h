@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../Events/Event.h"
+#include "../Events/EventQueue.h"
+#include "../Events/EventRecording.h"
 
 // Window API
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -33,6 +35,11 @@ namespace MyGame
 		static std::unique_ptr<Window> Create(WindowProps&&);
 
 		void OnUpdate();
+		// Runs the events queued by the GLFW callbacks since the last call through the event callback
+		void DispatchEvents();
+		EventQueue& GetEventQueue() { return m_Data.Events; }
+		// Also hands every raw event to the recorder, nullptr stops recording
+		void SetEventRecorder(EventRecorder* recorder) { m_Data.Recorder = recorder; }
 		void SetEventCallback(const std::function<void(Event&)>& callback) { m_Data.EventCallback = callback; }
 		void SetVSync(bool);
 		bool IsVSync() const;
@@ -53,6 +60,10 @@ namespace MyGame
 			bool VSync;
 
 			std::function<void(Event&)> EventCallback;
+			EventQueue Events; // Filled inside glfwPollEvents, dispatched by DispatchEvents
+			EventRecorder* Recorder = nullptr;
+
+			void Queue(const EventValue& event);
 		};
 
 		WindowData m_Data;
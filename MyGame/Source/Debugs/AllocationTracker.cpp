@@ -0,0 +1,201 @@
+#include "CommonHeaders.h"
+
+#include "AllocationTracker.h"
+#include "../Core/Log.h"
+
+#include <atomic>
+#include <malloc.h>
+#include <new>
+
+namespace MyGame
+{
+	namespace
+	{
+		struct AllocationSite
+		{
+			std::atomic<const char*> Name = nullptr;
+			std::atomic<uint64_t> Count = 0;
+			std::atomic<uint64_t> Bytes = 0;
+			std::atomic<int64_t> LiveBytes = 0;
+			std::atomic<int64_t> PeakBytes = 0;
+
+			void Add(size_t size)
+			{
+				Count.fetch_add(1, std::memory_order_relaxed);
+				Bytes.fetch_add(size, std::memory_order_relaxed);
+
+				const int64_t live = LiveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+				int64_t peak = PeakBytes.load(std::memory_order_relaxed);
+				while (live > peak && !PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+			}
+
+			void Remove(size_t size) { LiveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed); }
+		};
+
+		// Open addressing keyed by the name's address, every scope site has its own static string.
+		// The extra last site collects whatever doesn't fit anymore.
+		template<size_t N>
+		struct AllocationSiteTable
+		{
+			static_assert((N & (N - 1)) == 0, "AllocationSiteTable size must be a power of two");
+
+			std::array<AllocationSite, N + 1> Sites;
+
+			uint16_t Find(const char* name)
+			{
+				size_t index = (reinterpret_cast<uintptr_t>(name) >> 4) & (N - 1);
+				for (size_t probe = 0; probe < N; probe++, index = (index + 1) & (N - 1))
+				{
+					const char* current = Sites[index].Name.load(std::memory_order_acquire);
+					if (current == name)
+						return (uint16_t)index;
+					if (!current && (Sites[index].Name.compare_exchange_strong(current, name, std::memory_order_acq_rel) || current == name))
+						return (uint16_t)index;
+				}
+
+				Sites[N].Name.store("<overflow>", std::memory_order_relaxed);
+				return (uint16_t)N;
+			}
+
+			std::vector<AllocationStats> GetStats() const
+			{
+				std::vector<AllocationStats> stats;
+				for (const AllocationSite& site : Sites)
+				{
+					if (const char* name = site.Name.load(std::memory_order_acquire))
+						stats.push_back({ name, site.Count.load(), site.Bytes.load(), site.LiveBytes.load(), site.PeakBytes.load() });
+				}
+
+				std::sort(stats.begin(), stats.end(), [](const AllocationStats& a, const AllocationStats& b) { return a.Bytes > b.Bytes; });
+				return stats;
+			}
+		};
+
+		// Keeps user pointers aligned to the default new alignment
+		struct alignas(16) AllocationHeader
+		{
+			uint64_t Size;
+			uint16_t Scope;
+			uint16_t Tag;
+		};
+
+		constexpr char s_NoScope[] = "<no scope>";
+		constexpr char s_NoTag[] = "<untagged>";
+
+		// Constant initialized, operator new can run before any dynamic initializer
+		constinit AllocationSiteTable<1024> s_Scopes;
+		constinit AllocationSiteTable<64> s_Tags;
+		constinit AllocationSite s_Total;
+
+		constinit thread_local const char* t_Scope = nullptr;
+		constinit thread_local const char* t_Tag = nullptr;
+
+#ifdef MYGAME_TRACK_ALLOCATIONS
+		void* Allocate(size_t size, size_t alignment)
+		{
+			const bool aligned = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+			const size_t offset = std::max(alignment, sizeof(AllocationHeader));
+
+			char* block = static_cast<char*>(aligned ? _aligned_malloc(size + offset, alignment) : std::malloc(size + offset));
+			if (!block)
+				return nullptr;
+
+			AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block + offset) - 1;
+			header->Size = size;
+			header->Scope = s_Scopes.Find(t_Scope ? t_Scope : s_NoScope);
+			header->Tag = s_Tags.Find(t_Tag ? t_Tag : s_NoTag);
+
+			s_Scopes.Sites[header->Scope].Add(size);
+			s_Tags.Sites[header->Tag].Add(size);
+			s_Total.Add(size);
+			return block + offset;
+		}
+
+		void Free(void* pointer, size_t alignment)
+		{
+			if (!pointer)
+				return;
+
+			const AllocationHeader* header = static_cast<AllocationHeader*>(pointer) - 1;
+			s_Scopes.Sites[header->Scope].Remove(header->Size);
+			s_Tags.Sites[header->Tag].Remove(header->Size);
+			s_Total.Remove(header->Size);
+
+			char* block = static_cast<char*>(pointer) - std::max(alignment, sizeof(AllocationHeader));
+			if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+				_aligned_free(block);
+			else
+				std::free(block);
+		}
+#endif
+	}
+
+	const char* AllocationTracker::SetScope(const char* name)
+	{
+		const char* previous = t_Scope;
+		t_Scope = name;
+		return previous;
+	}
+
+	const char* AllocationTracker::SetTag(const char* name)
+	{
+		const char* previous = t_Tag;
+		t_Tag = name;
+		return previous;
+	}
+
+	std::vector<AllocationStats> AllocationTracker::GetScopeStats() { return s_Scopes.GetStats(); }
+	std::vector<AllocationStats> AllocationTracker::GetTagStats() { return s_Tags.GetStats(); }
+
+	int64_t AllocationTracker::GetLiveBytes() { return s_Total.LiveBytes.load(std::memory_order_relaxed); }
+	int64_t AllocationTracker::GetPeakBytes() { return s_Total.PeakBytes.load(std::memory_order_relaxed); }
+	uint64_t AllocationTracker::GetAllocationCount() { return s_Total.Count.load(std::memory_order_relaxed); }
+
+	void AllocationTracker::LogSummary(size_t count)
+	{
+		if (!IsEnabled() || !Log::GetLogger())
+			return;
+
+		MYGAME_INFO("Heap: {0} allocations, {1} bytes live, {2} bytes peak", GetAllocationCount(), GetLiveBytes(), GetPeakBytes());
+
+		const std::vector<AllocationStats> scopes = GetScopeStats();
+		for (size_t i = 0; i < std::min(count, scopes.size()); i++)
+			MYGAME_INFO("  {0}: {1} allocations, {2} bytes, {3} bytes peak", scopes[i].Name, scopes[i].Count, scopes[i].Bytes, scopes[i].PeakBytes);
+
+		for (const AllocationStats& tag : GetTagStats())
+			MYGAME_INFO("  [{0}]: {1} allocations, {2} bytes, {3} bytes peak", tag.Name, tag.Count, tag.Bytes, tag.PeakBytes);
+	}
+}
+
+#ifdef MYGAME_TRACK_ALLOCATIONS
+
+void* operator new(size_t size)
+{
+	if (void* pointer = MyGame::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return MyGame::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return MyGame::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	if (void* pointer = MyGame::Allocate(size, (size_t)alignment))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+
+void operator delete(void* pointer) noexcept { MyGame::Free(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete[](void* pointer) noexcept { MyGame::Free(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete(void* pointer, size_t) noexcept { MyGame::Free(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete[](void* pointer, size_t) noexcept { MyGame::Free(pointer, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete(void* pointer, std::align_val_t alignment) noexcept { MyGame::Free(pointer, (size_t)alignment); }
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept { MyGame::Free(pointer, (size_t)alignment); }
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept { MyGame::Free(pointer, (size_t)alignment); }
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept { MyGame::Free(pointer, (size_t)alignment); }
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Opt-in, build with MYGAME_TRACK_ALLOCATIONS defined (premake5 --track-allocations).
+// Global operator new/delete then attribute every allocation to the innermost
+// MYGAME_PROFILE_SCOPE / FUNCTION of the calling thread and to the innermost
+// MYGAME_ALLOCATION_TAG. Nothing in here allocates, it runs inside operator new.
+
+namespace MyGame
+{
+	struct AllocationStats
+	{
+		const char* Name;
+		uint64_t Count;
+		uint64_t Bytes;
+		int64_t LiveBytes;
+		int64_t PeakBytes;
+	};
+
+	class AllocationTracker
+	{
+	public:
+		static constexpr bool IsEnabled()
+		{
+#ifdef MYGAME_TRACK_ALLOCATIONS
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		// Both return the previous value so the caller can restore it when its scope ends
+		static const char* SetScope(const char* name);
+		static const char* SetTag(const char* name);
+
+		// Totals since startup, sorted by bytes allocated
+		static std::vector<AllocationStats> GetScopeStats();
+		static std::vector<AllocationStats> GetTagStats();
+
+		static int64_t GetLiveBytes();
+		static int64_t GetPeakBytes();
+		static uint64_t GetAllocationCount();
+
+		static void LogSummary(size_t count = 10);
+	};
+
+	// RAII, see MYGAME_ALLOCATION_TAG
+	class AllocationTag
+	{
+	public:
+		AllocationTag(const char* name) : m_Previous(AllocationTracker::SetTag(name)) {}
+		~AllocationTag() { AllocationTracker::SetTag(m_Previous); }
+
+		AllocationTag(const AllocationTag&) = delete;
+		AllocationTag& operator=(const AllocationTag&) = delete;
+
+	private:
+		const char* m_Previous;
+	};
+}
+
+#ifdef MYGAME_TRACK_ALLOCATIONS
+#define MYGAME_ALLOCATION_TAG_LINE2(name, line) ::MyGame::AllocationTag allocationTag##line(name)
+#define MYGAME_ALLOCATION_TAG_LINE(name, line) MYGAME_ALLOCATION_TAG_LINE2(name, line)
+#define MYGAME_ALLOCATION_TAG(name) MYGAME_ALLOCATION_TAG_LINE(name, __LINE__)
+#else
+#define MYGAME_ALLOCATION_TAG(name)
+#endif
@@ -23,7 +23,8 @@
 #define MYGAME_VERIFY_HRESULT(x) { if (FAILED(x)) { MYGAME_HRESULT_TOSTR(x); return false; } }
 
 #ifdef MYGAME_ENABLE_INFO_EVENTS 
-#define MYGAME_INFO_EVENTS(x) MYGAME_INFO("{0}", x.ToString());
+#include "../Events/EventValue.h"
+#define MYGAME_INFO_EVENTS(x) MYGAME_INFO("{0}", ::MyGame::ToEventValue(x));
 #else
 #define MYGAME_INFO_EVENTS(x)
 #endif 
@@ -0,0 +1,81 @@
+#include "CommonHeaders.h"
+
+#include "InputLatency.h"
+
+namespace MyGame
+{
+	// Latencies are measured whether the profiler runs or not, so not with the ProfilerClock,
+	// which is only calibrated once a capture begins
+	static int64_t NowNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void InputLatency::OnInput()
+	{
+		if (s_PendingInput)
+			return;
+
+		s_PendingInput = NowNanoseconds();
+		MYGAME_PROFILE_FLOW_BEGIN(s_PendingFlow, "Input to present");
+	}
+
+	void InputLatency::OnInputConsumed()
+	{
+		if (!s_PendingInput)
+			return;
+
+		// A frame that never presented (minimized) hands its input on, the older timestamp wins
+		if (!s_FrameInput)
+		{
+			s_FrameInput = s_PendingInput;
+			s_FrameFlow = s_PendingFlow;
+		}
+		else
+		{
+			// The newer input is measured through the older one, close its flow here
+			MYGAME_PROFILE_FLOW_END(s_PendingFlow, "Input to present");
+		}
+		s_PendingInput = 0;
+		s_PendingFlow = {};
+	}
+
+	void InputLatency::OnPresent()
+	{
+		if (!s_FrameInput)
+			return;
+
+		const int64_t nanoseconds = NowNanoseconds() - s_FrameInput;
+		s_LastMilliseconds = nanoseconds / 1'000'000.0f;
+		s_Histogram[std::min((int)(nanoseconds / 1'000'000), BucketCount - 1)]++;
+		s_SampleCount++;
+
+		MYGAME_PROFILE_COUNTER("Input latency (ms)", s_LastMilliseconds);
+		MYGAME_PROFILE_FLOW_END(s_FrameFlow, "Input to present");
+		s_FrameInput = 0;
+		s_FrameFlow = {};
+	}
+
+	float InputLatency::GetPercentileMilliseconds(float percentile)
+	{
+		if (!s_SampleCount)
+			return 0.0f;
+
+		const uint64_t rank = std::max<uint64_t>((uint64_t)(s_SampleCount * percentile / 100.0f + 0.5f), 1);
+		uint64_t count = 0;
+		for (int bucket = 0; bucket < BucketCount; bucket++)
+		{
+			count += s_Histogram[bucket];
+			if (count >= rank)
+				return (float)(bucket + 1);
+		}
+		return (float)BucketCount;
+	}
+
+	void InputLatency::Reset()
+	{
+		s_LastMilliseconds = 0.0f;
+		s_SampleCount = 0;
+		s_Histogram = {};
+	}
+}
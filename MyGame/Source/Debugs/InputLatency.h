@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Instrumentor.h"
+
+#include <array>
+#include <cstdint>
+
+namespace MyGame
+{
+	// Time from the oldest input event a frame reacts to until that frame is presented. The GLFW
+	// callbacks stamp the first input not consumed yet, the frame dispatching it takes it over and
+	// Present closes it. Main thread only.
+	//
+	// Every sample goes into a running histogram and the "Input latency (ms)" counter track, and is
+	// also an "Input to present" flow, so statistics sessions report its percentiles.
+	class InputLatency
+	{
+	public:
+		static constexpr int BucketCount = 100; // 1 ms each, the last one also counts everything slower
+
+		static void OnInput();
+		static void OnInputConsumed();
+		static void OnPresent();
+
+		static float GetLastMilliseconds() { return s_LastMilliseconds; }
+		static uint64_t GetSampleCount() { return s_SampleCount; }
+		static const std::array<uint32_t, BucketCount>& GetHistogram() { return s_Histogram; }
+		// Upper edge of the bucket the percentile (0 - 100) falls in
+		static float GetPercentileMilliseconds(float percentile);
+		static void Reset();
+
+	private:
+		inline static int64_t s_PendingInput = 0; // Polled, not dispatched yet
+		inline static int64_t s_FrameInput = 0;   // Dispatched, waiting for the frame's Present
+		inline static ProfileFlow s_PendingFlow;
+		inline static ProfileFlow s_FrameFlow;
+
+		inline static float s_LastMilliseconds = 0.0f;
+		inline static uint64_t s_SampleCount = 0;
+		inline static std::array<uint32_t, BucketCount> s_Histogram = {};
+	};
+}
@@ -0,0 +1,741 @@
+#include "CommonHeaders.h"
+
+#include "Instrumentor.h"
+#include "TraceFile.h"
+
+#include <sstream>
+
+namespace MyGame
+{
+	// How often the writer thread wakes up to drain the per-thread buffers
+	static constexpr std::chrono::milliseconds s_WriterInterval(2);
+
+	static TraceFile::FlowPhase GetFlowPhase(const ProfileResult& result)
+	{
+		return result.Type == ProfileResultType::FlowBegin ? TraceFile::FlowPhase::Begin : TraceFile::FlowPhase::End;
+	}
+
+	void Instrumentor::BeginSession(const std::string& name, const std::string& filepath, InstrumentationMode mode)
+	{
+		ProfilerClock::EnsureCalibrated();
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			if (m_CurrentSession)
+			{
+				// If there is already a current session, then close it before beginning new one.
+				// Subsequent profiling output meant for the original session will end up in the
+				// newly opened session instead.  That's better than having badly formatted
+				// profiling output.
+
+				if (Log::GetLogger()) // Edge case: BeginSession() might be before Log::Init()
+					MYGAME_ERROR("Instrumentor::BeginSession('{0}') when session '{1}' already open.", name, m_CurrentSession->Name);
+
+				InternalEndSession();
+			}
+			const bool binary = mode == InstrumentationMode::Trace && TraceFile::IsBinaryPath(filepath);
+			m_OutputStream.open(filepath, binary ? std::ios::out | std::ios::binary : std::ios::out);
+
+			if (m_OutputStream.is_open())
+			{
+				m_CurrentSession = new InstrumentationSession({ name, mode, binary, std::chrono::steady_clock::now().time_since_epoch().count() });
+				if (mode == InstrumentationMode::Statistics && !++m_StatisticsGeneration)
+					m_StatisticsGeneration = 1;
+				m_NamesWritten.clear();
+				m_ThreadsWritten.clear();
+				WriteHeader();
+
+				if (Log::GetLogger())
+					MYGAME_INFO("Profiler clock: {0}, {1:.3f} ns per tick, {2} ticks subtracted per scope",
+						ProfilerClock::IsUsingTSC() ? "invariant TSC" : "steady_clock", ProfilerClock::GetNanosecondsPerTick(), ProfilerClock::GetOverheadTicks());
+			}
+			else
+			{
+				if (Log::GetLogger()) // Edge case: BeginSession() might be before Log::Init()
+					MYGAME_ERROR("Instrumentor could not open results file '{0}'.", filepath);
+			}
+		}
+		UpdateCapturing();
+	}
+
+	void Instrumentor::EndSession()
+	{
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			InternalEndSession();
+		}
+		UpdateCapturing();
+	}
+
+	void Instrumentor::ToggleSession(const std::string& name, const std::string& filepath)
+	{
+		if (IsSessionActive())
+		{
+			EndSession();
+			MYGAME_INFO("Profiling session '{0}' stopped", name);
+		}
+		else
+		{
+			BeginSession(name, filepath);
+			MYGAME_INFO("Profiling session '{0}' started, writing to '{1}'", name, filepath);
+		}
+	}
+
+	void Instrumentor::WriteStatistics()
+	{
+		std::lock_guard lock(m_Mutex);
+		if (m_CurrentSession && m_CurrentSession->Mode == InstrumentationMode::Statistics)
+		{
+			WriteStatisticsRows(CollectStatistics());
+			m_OutputStream.flush();
+		}
+	}
+
+	std::vector<ScopeSummary> Instrumentor::GetStatistics()
+	{
+		std::lock_guard lock(m_Mutex);
+		if (m_CurrentSession && m_CurrentSession->Mode == InstrumentationMode::Statistics)
+			return CollectStatistics();
+		return {};
+	}
+
+	bool Instrumentor::IsSessionActive()
+	{
+		std::lock_guard lock(m_Mutex);
+		return m_CurrentSession != nullptr;
+	}
+
+	void Instrumentor::BeginHitchCapture(const HitchCaptureSettings& settings)
+	{
+		ProfilerClock::EnsureCalibrated();
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			if (!KeepsFrameHistory())
+			{
+				m_Frames.clear();
+				m_PendingEvents.clear();
+			}
+
+			m_HitchCapture = settings;
+			m_HitchCapture->FrameCount = std::max(settings.FrameCount, settings.FramesAfter + 1);
+			m_Hitch.reset();
+		}
+		UpdateCapturing();
+
+		MYGAME_INFO("Hitch capture started, frames over {0} ms are written to '{1}'", settings.ThresholdMs, settings.OutputDirectory);
+	}
+
+	void Instrumentor::EndHitchCapture()
+	{
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			if (m_HitchCapture)
+				DrainBuffers();
+
+			m_HitchCapture.reset();
+			m_Hitch.reset();
+			if (!KeepsFrameHistory())
+			{
+				m_Frames.clear();
+				m_PendingEvents.clear();
+			}
+		}
+		UpdateCapturing();
+	}
+
+	void Instrumentor::SetSamplingInterval(std::chrono::microseconds interval)
+	{
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			m_SamplingInterval = interval.count() > 0 ? std::max(interval, SamplingProfiler::MinInterval) : std::chrono::microseconds(0);
+		}
+
+		// Restarts with the new interval if a trace session is running
+		m_Sampler.Stop();
+		UpdateCapturing();
+	}
+
+	void Instrumentor::SetLiveCapture(bool enabled)
+	{
+		if (enabled)
+			ProfilerClock::EnsureCalibrated();
+		std::lock_guard control(m_ControlMutex);
+		{
+			std::lock_guard lock(m_Mutex);
+			m_LiveCapture = enabled;
+			if (!KeepsFrameHistory())
+			{
+				m_Frames.clear();
+				m_PendingEvents.clear();
+			}
+		}
+		UpdateCapturing();
+	}
+
+	bool Instrumentor::IsLiveCaptureEnabled()
+	{
+		std::lock_guard lock(m_Mutex);
+		return m_LiveCapture;
+	}
+
+	uint64_t Instrumentor::CopyFrameHistory(uint64_t firstIndex, std::vector<ProfileFrame>& frames)
+	{
+		static constexpr uint64_t settleFrames = 2;
+
+		std::lock_guard lock(m_Mutex);
+		if (m_Frames.empty())
+			return firstIndex;
+
+		const uint64_t lastIndex = m_Frames.back().Index;
+		for (const ProfileFrame& frame : m_Frames)
+		{
+			if (frame.Index >= firstIndex && frame.Index + settleFrames <= lastIndex)
+			{
+				frames.push_back(frame);
+				firstIndex = frame.Index + 1;
+			}
+		}
+		return firstIndex;
+	}
+
+	std::vector<ProfileThreadInfo> Instrumentor::GetThreads()
+	{
+		std::vector<ProfileThreadInfo> threads;
+
+		std::lock_guard lock(m_BuffersMutex);
+		for (auto& buffer : m_ThreadBuffers)
+			threads.push_back({ buffer->GetThreadID(), buffer->GetName(), buffer->GetUtilizationScopeID() });
+		return threads;
+	}
+
+	void Instrumentor::SetThreadName(const std::string& name)
+	{
+		ProfileThreadBuffer& buffer = GetThreadBuffer();
+
+		std::lock_guard lock(m_BuffersMutex);
+		buffer.SetName(name);
+	}
+
+	// Main thread only. The CPU time every thread ran during the last frame, as a percentage of the
+	// frame: 100 is one core busy for the whole frame, a thread that mostly waits stays near 0.
+	void Instrumentor::WriteThreadUtilization(int64_t frameStart, int64_t frameEnd)
+	{
+		static constexpr std::string_view prefix = "Utilization: ";
+
+		{
+			std::lock_guard lock(m_BuffersMutex);
+			for (size_t threadIndex = m_ThreadUtilization.size(); threadIndex < m_ThreadBuffers.size(); threadIndex++)
+			{
+				ProfileThreadBuffer& buffer = *m_ThreadBuffers[threadIndex];
+				ThreadUtilization& thread = m_ThreadUtilization.emplace_back();
+
+				std::stringstream name;
+				name << prefix;
+				if (buffer.GetName().empty())
+					name << "Thread " << buffer.GetThreadID();
+				else
+					name << buffer.GetName();
+				name << " (%)";
+
+				thread.Name = name.str();
+				thread.Scope = std::make_unique<ProfileScope>(thread.Name.c_str());
+				thread.Handle = ThreadCpuTime::Open(buffer.GetThreadID());
+				buffer.SetUtilizationScopeID(thread.Scope->ID);
+			}
+		}
+
+		// The CPU times read last are only a baseline for this frame if nothing was skipped in between
+		const bool consecutive = frameStart == m_LastUtilizationFrameEnd;
+		m_LastUtilizationFrameEnd = frameEnd;
+
+		const double frameNanoseconds = (double)ProfilerClock::ToFrameDuration(frameEnd - frameStart);
+		for (ThreadUtilization& thread : m_ThreadUtilization)
+		{
+			if (!thread.Handle)
+				continue;
+
+			const int64_t cpuTime = ThreadCpuTime::Get(thread.Handle);
+			if (consecutive && thread.LastCpuTime && frameNanoseconds > 0.0)
+				WriteCounter(*thread.Scope, 100.0 * (cpuTime - thread.LastCpuTime) / frameNanoseconds);
+			thread.LastCpuTime = cpuTime;
+		}
+	}
+
+	void Instrumentor::RegisterScope(ProfileScope& scope)
+	{
+		// Logged after the lock is released: the console sink's lock is profiled, and registering
+		// its scopes would lock m_ScopesMutex again on this thread
+		const char* registeredName;
+		{
+			std::lock_guard lock(m_ScopesMutex);
+			registeredName = m_ScopeNames.try_emplace(scope.ID, scope.Name).first->second;
+		}
+		if (std::strcmp(registeredName, scope.Name) != 0 && Log::GetLogger())
+			MYGAME_WARN("Profile scopes '{0}' and '{1}' share the ID {2:#x}, traces will show both as the first one.", registeredName, scope.Name, scope.ID);
+
+		scope.Registered.store(true, std::memory_order_release);
+	}
+
+	void Instrumentor::UpdateCapturing()
+	{
+		bool recording;
+		bool collectingStatistics;
+		std::chrono::microseconds samplingInterval{ 0 };
+		{
+			std::lock_guard lock(m_Mutex);
+			recording = IsTracing() || KeepsFrameHistory();
+			collectingStatistics = m_CurrentSession && m_CurrentSession->Mode == InstrumentationMode::Statistics;
+			if (IsTracing())
+				samplingInterval = m_SamplingInterval;
+		}
+
+		// Statistics are accumulated by the recording threads themselves, no writer needed
+		s_StatisticsGeneration.store(collectingStatistics ? m_StatisticsGeneration : 0, std::memory_order_release);
+		if (collectingStatistics)
+			s_Capturing.store(true, std::memory_order_release);
+
+		if (recording && !m_Writer.joinable())
+		{
+			// Leftovers of a previous capture were recorded after its final drain
+			{
+				std::lock_guard buffersLock(m_BuffersMutex);
+				for (auto& buffer : m_ThreadBuffers)
+					buffer->Discard();
+			}
+
+			m_WriterRunning = true;
+			m_Writer = std::thread(&Instrumentor::WriterThread, this);
+			s_RecordingEvents.store(true, std::memory_order_release);
+		}
+		else if (!recording && m_Writer.joinable())
+		{
+			s_RecordingEvents.store(false, std::memory_order_release);
+			{
+				std::lock_guard wakeLock(m_WriterMutex);
+				m_WriterRunning = false;
+			}
+			m_WriterWakeup.notify_one();
+			m_Writer.join();
+
+			uint64_t dropped = 0;
+			{
+				std::lock_guard buffersLock(m_BuffersMutex);
+				for (auto& buffer : m_ThreadBuffers)
+					dropped += buffer->TakeDropped();
+			}
+			if (dropped && Log::GetLogger())
+				MYGAME_WARN("Instrumentor dropped {0} events, the per-thread buffers were full.", dropped);
+		}
+
+		// The writer symbolizes and writes the samples, so the sampler only runs next to a trace session
+		if (samplingInterval.count() > 0)
+		{
+			m_Sampler.Start(samplingInterval);
+		}
+		else if (m_Sampler.IsRunning())
+		{
+			m_Sampler.Stop();
+			if (const uint64_t dropped = m_Sampler.TakeDropped(); dropped && Log::GetLogger())
+				MYGAME_WARN("Sampling profiler dropped {0} samples, the writer fell behind.", dropped);
+		}
+
+		s_Capturing.store(recording || collectingStatistics, std::memory_order_release);
+	}
+
+	ProfileThreadBuffer* Instrumentor::RegisterThread()
+	{
+		std::stringstream id;
+		id << std::this_thread::get_id();
+
+		std::lock_guard lock(m_BuffersMutex);
+		m_ThreadBuffers.emplace_back(std::make_unique<ProfileThreadBuffer>(std::stoull(id.str()), (uint32_t)m_ThreadBuffers.size()));
+		m_Sampler.AddThread(m_ThreadBuffers.back()->GetThreadID(), m_ThreadBuffers.back()->GetThreadIndex());
+		return m_ThreadBuffers.back().get();
+	}
+
+	void Instrumentor::WriterThread()
+	{
+		SetThreadName("Profiler writer");
+
+		while (true)
+		{
+			{
+				std::unique_lock wakeLock(m_WriterMutex);
+				m_WriterWakeup.wait_for(wakeLock, s_WriterInterval, [this] { return !m_WriterRunning; });
+				if (!m_WriterRunning)
+					break;
+			}
+
+			std::lock_guard lock(m_Mutex);
+			DrainBuffers();
+		}
+	}
+
+	// Note: you must already own lock on m_Mutex before calling DrainBuffers()
+	void Instrumentor::DrainBuffers()
+	{
+		std::vector<ProfileFrame::Event> events;
+		{
+			std::lock_guard lock(m_BuffersMutex);
+			std::lock_guard scopesLock(m_ScopesMutex);
+			for (auto& buffer : m_ThreadBuffers)
+			{
+				buffer->Drain([&](ProfileResult result)
+					{
+						result.Start = ProfilerClock::ToNanoseconds(result.Start);
+						if (result.Type == ProfileResultType::Scope)
+							result.ElapsedTime = ProfilerClock::ToDuration(result.ElapsedTime);
+						else if (result.Type == ProfileResultType::Frame)
+							result.ElapsedTime = ProfilerClock::ToFrameDuration(result.ElapsedTime);
+
+						const char* name = GetScopeName(result);
+						if (IsTracing())
+							WriteRecord(result, name, *buffer);
+						if (KeepsFrameHistory())
+							events.push_back({ result, buffer->GetThreadIndex(), name });
+					});
+			}
+		}
+
+		m_Sampler.Drain([this](const SamplingProfiler::Sample& sample)
+			{
+				if (IsTracing())
+					WriteSample(sample);
+			});
+
+		if (KeepsFrameHistory() && !events.empty())
+			UpdateFrameHistory(events);
+	}
+
+	// Note: you must already own lock on m_ScopesMutex before calling GetScopeName()
+	const char* Instrumentor::GetScopeName(const ProfileResult& result) const
+	{
+		if (result.Type == ProfileResultType::Frame)
+			return "Frame";
+
+		auto it = m_ScopeNames.find(result.ScopeID);
+		return it != m_ScopeNames.end() ? it->second : "<unknown>";
+	}
+
+	// Only the writer thread gets here, so the stream needs no extra buffering or flushing
+	void Instrumentor::WriteRecord(const ProfileResult& result, const char* name, const ProfileThreadBuffer& buffer)
+	{
+		if (!m_CurrentSession->Binary)
+		{
+			if (result.Type == ProfileResultType::Counter)
+				TraceFile::WriteChromeCounter(m_OutputStream, name, buffer.GetThreadID(), result.Start, result.Value);
+			else if (result.Type == ProfileResultType::FlowBegin || result.Type == ProfileResultType::FlowEnd)
+				TraceFile::WriteChromeFlow(m_OutputStream, name, GetFlowPhase(result), buffer.GetThreadID(), result.Start, result.FlowID);
+			else
+				TraceFile::WriteChromeScope(m_OutputStream, name, buffer.GetThreadID(), result.Start, result.ElapsedTime);
+			return;
+		}
+
+		const uint32_t threadIndex = WriteThread(buffer.GetThreadIndex(), buffer.GetThreadID());
+
+		if (result.Type == ProfileResultType::Frame)
+			TraceFile::Write(m_OutputStream, TraceFile::RecordType::Frame, TraceFile::FrameRecord{ threadIndex, result.Start, result.ElapsedTime });
+		else if (result.Type == ProfileResultType::Counter)
+			TraceFile::Write(m_OutputStream, TraceFile::RecordType::Counter, TraceFile::CounterRecord{ WriteName(result.ScopeID, name), threadIndex, result.Start, result.Value });
+		else if (result.Type == ProfileResultType::FlowBegin || result.Type == ProfileResultType::FlowEnd)
+			TraceFile::Write(m_OutputStream, TraceFile::RecordType::Flow, TraceFile::FlowRecord{ WriteName(result.ScopeID, name), threadIndex, result.Start, result.FlowID, GetFlowPhase(result) });
+		else
+			TraceFile::Write(m_OutputStream, TraceFile::RecordType::Scope, TraceFile::ScopeRecord{ WriteName(result.ScopeID, name), threadIndex, result.Start, result.ElapsedTime });
+	}
+
+	// Note: you must already own lock on m_Mutex before calling WriteSample()
+	void Instrumentor::WriteSample(const SamplingProfiler::Sample& sample)
+	{
+		const int64_t timestamp = ProfilerClock::ToNanoseconds(sample.Timestamp);
+		if (!m_CurrentSession->Binary)
+		{
+			std::string stack;
+			for (uint32_t i = sample.Depth; i-- > 0;)
+			{
+				stack += m_Sampler.GetSymbol(sample.Frames[i]).Name;
+				if (i)
+					stack += ';';
+			}
+			TraceFile::WriteChromeSample(m_OutputStream, m_Sampler.GetSymbol(sample.Frames[0]).Name, sample.ThreadID, timestamp, stack);
+			return;
+		}
+
+		std::array<uint32_t, SamplingProfiler::MaxDepth> nameIDs;
+		for (uint32_t i = 0; i < sample.Depth; i++)
+		{
+			const SamplingProfiler::Symbol& symbol = m_Sampler.GetSymbol(sample.Frames[i]);
+			nameIDs[i] = WriteName(symbol.NameID, symbol.Name.c_str());
+		}
+
+		const uint32_t threadIndex = WriteThread(sample.ThreadIndex, sample.ThreadID);
+		TraceFile::Write(m_OutputStream, TraceFile::RecordType::Sample, TraceFile::SampleRecord{ threadIndex, timestamp, sample.Depth });
+		m_OutputStream.write(reinterpret_cast<const char*>(nameIDs.data()), sample.Depth * sizeof(uint32_t));
+	}
+
+	// Every thread goes into a binary session once, right before its first record
+	uint32_t Instrumentor::WriteThread(uint32_t threadIndex, uint64_t threadID)
+	{
+		if (threadIndex >= m_ThreadsWritten.size())
+			m_ThreadsWritten.resize(threadIndex + 1);
+		if (!m_ThreadsWritten[threadIndex])
+		{
+			TraceFile::Write(m_OutputStream, TraceFile::RecordType::Thread, TraceFile::ThreadRecord{ threadIndex, threadID });
+			m_ThreadsWritten[threadIndex] = true;
+		}
+		return threadIndex;
+	}
+
+	// Every name goes into a session once, right before the first record using it
+	uint32_t Instrumentor::WriteName(uint32_t nameID, const char* name)
+	{
+		if (m_NamesWritten.insert(nameID).second)
+			TraceFile::WriteName(m_OutputStream, nameID, name);
+		return nameID;
+	}
+
+	void Instrumentor::UpdateFrameHistory(std::vector<ProfileFrame::Event>& events)
+	{
+		// Frame marks first, they decide which frame every other event belongs to
+		std::stable_partition(events.begin(), events.end(), [](const ProfileFrame::Event& event) { return event.Result.Type == ProfileResultType::Frame; });
+
+		for (const ProfileFrame::Event& event : events)
+		{
+			const ProfileResult& result = event.Result;
+			if (result.Type == ProfileResultType::Frame)
+			{
+				ProfileFrame& frame = m_Frames.emplace_back();
+				frame.Index = m_FrameIndex++;
+				frame.Start = result.Start;
+				frame.Duration = result.ElapsedTime;
+				frame.ThreadIndex = event.ThreadIndex;
+
+				// Whatever started before the end of this frame belongs to it
+				const int64_t end = frame.Start + frame.Duration;
+				auto it = std::stable_partition(m_PendingEvents.begin(), m_PendingEvents.end(), [end](const ProfileFrame::Event& pending) { return pending.Result.Start < end; });
+				frame.Events.assign(m_PendingEvents.begin(), it);
+				m_PendingEvents.erase(m_PendingEvents.begin(), it);
+
+				if (m_HitchCapture && !m_Hitch && frame.Duration > (int64_t)(m_HitchCapture->ThresholdMs * 1'000'000.0f))
+				{
+					m_Hitch = ProfileFrame{ frame.Index, frame.Start, frame.Duration, frame.ThreadIndex, {} };
+					m_HitchDumpFrame = frame.Index + m_HitchCapture->FramesAfter;
+				}
+
+				const uint32_t frameCount = std::max(m_HitchCapture ? m_HitchCapture->FrameCount : 0, m_LiveCapture ? LiveFrameCount : 0);
+				while (m_Frames.size() > frameCount)
+					m_Frames.pop_front();
+			}
+			else if (m_Frames.empty() || result.Start >= m_Frames.back().Start + m_Frames.back().Duration)
+			{
+				m_PendingEvents.push_back(event);
+			}
+			else
+			{
+				// Late event from a thread whose buffer got drained after the frame was closed
+				auto it = std::upper_bound(m_Frames.begin(), m_Frames.end(), result.Start, [](int64_t start, const ProfileFrame& frame) { return start < frame.Start; });
+				if (it != m_Frames.begin())
+					std::prev(it)->Events.push_back(event);
+			}
+		}
+
+		if (m_Hitch && !m_Frames.empty() && m_Frames.back().Index >= m_HitchDumpFrame)
+		{
+			DumpFrameHistory(*m_Hitch);
+			m_Hitch.reset();
+		}
+	}
+
+	void Instrumentor::DumpFrameHistory(const ProfileFrame& hitch)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(m_HitchCapture->OutputDirectory, error);
+
+		std::stringstream filename;
+		filename << "Hitch_" << hitch.Index << "_" << hitch.Duration / 1'000'000 << "ms.json";
+		const std::filesystem::path filepath = std::filesystem::path(m_HitchCapture->OutputDirectory) / filename.str();
+
+		std::ofstream stream(filepath);
+		if (!stream)
+		{
+			MYGAME_ERROR("Instrumentor could not open hitch capture file '{0}'.", filepath.string());
+			return;
+		}
+
+		const std::vector<ProfileThreadInfo> threads = GetThreads();
+
+		TraceFile::WriteChromeHeader(stream);
+		for (const ProfileThreadInfo& thread : threads)
+			if (!thread.Name.empty())
+				TraceFile::WriteChromeThreadName(stream, thread.ThreadID, thread.Name);
+		for (const ProfileFrame& frame : m_Frames)
+		{
+			TraceFile::WriteChromeScope(stream, frame.Index == hitch.Index ? "Frame (hitch)" : "Frame", threads[frame.ThreadIndex].ThreadID, frame.Start, frame.Duration);
+			for (const ProfileFrame::Event& event : frame.Events)
+			{
+				if (event.Result.Type == ProfileResultType::Counter)
+					TraceFile::WriteChromeCounter(stream, event.Name, threads[event.ThreadIndex].ThreadID, event.Result.Start, event.Result.Value);
+				else if (event.Result.Type == ProfileResultType::FlowBegin || event.Result.Type == ProfileResultType::FlowEnd)
+					TraceFile::WriteChromeFlow(stream, event.Name, GetFlowPhase(event.Result), threads[event.ThreadIndex].ThreadID, event.Result.Start, event.Result.FlowID);
+				else
+					TraceFile::WriteChromeScope(stream, event.Name, threads[event.ThreadIndex].ThreadID, event.Result.Start, event.Result.ElapsedTime);
+			}
+		}
+		TraceFile::WriteChromeFooter(stream);
+
+		MYGAME_WARN("Frame {0} took {1:.2f} ms, wrote the last {2} frames to '{3}'", hitch.Index, hitch.Duration / 1'000'000.0, m_Frames.size(), filepath.string());
+	}
+
+	void Instrumentor::WriteHeader()
+	{
+		if (m_CurrentSession->Mode == InstrumentationMode::Statistics)
+			m_OutputStream << "Time (s),Scope,Calls,Total (ms),Mean (us),Min (us),Max (us),P50 (us),P90 (us),P99 (us),P99.9 (us),Cycles/call,IPC,Cache misses/call,Branch misses/call,Context switches/call\n";
+		else if (m_CurrentSession->Binary)
+			TraceFile::WriteBinaryHeader(m_OutputStream, m_CurrentSession->Name);
+		else
+			TraceFile::WriteChromeHeader(m_OutputStream);
+		m_OutputStream.flush();
+	}
+
+	// Totals per scope and tag since startup, written once when the session ends
+	void Instrumentor::WriteAllocations()
+	{
+		if (!AllocationTracker::IsEnabled() || !IsTracing())
+			return;
+
+		const int64_t now = ProfilerClock::ToNanoseconds(ProfilerClock::Now());
+		auto write = [&](const std::vector<AllocationStats>& stats, TraceFile::AllocationKind kind)
+		{
+			for (const AllocationStats& site : stats)
+			{
+				if (m_CurrentSession->Binary)
+					TraceFile::Write(m_OutputStream, TraceFile::RecordType::Allocation, TraceFile::AllocationRecord{ WriteName(TraceFile::HashName(site.Name), site.Name), kind, site.Count, site.Bytes, site.LiveBytes, site.PeakBytes });
+				else
+					TraceFile::WriteChromeAllocation(m_OutputStream, site.Name, kind, now, site.Count, site.Bytes, site.LiveBytes, site.PeakBytes);
+			}
+		};
+		write(AllocationTracker::GetScopeStats(), TraceFile::AllocationKind::Scope);
+		write(AllocationTracker::GetTagStats(), TraceFile::AllocationKind::Tag);
+
+		AllocationTracker::LogSummary();
+	}
+
+	void Instrumentor::WriteStatisticsRows(const std::vector<ScopeSummary>& statistics)
+	{
+		const double elapsed = (std::chrono::steady_clock::now().time_since_epoch().count() - m_CurrentSession->Start) / 1e9;
+		m_OutputStream << std::setprecision(3) << std::fixed;
+		for (const ScopeSummary& summary : statistics)
+		{
+			m_OutputStream << elapsed << ',';
+			TraceFile::WriteCsvString(m_OutputStream, summary.Name);
+			m_OutputStream << ',' << summary.Count << ',' << summary.Total / 1e6 << ',' << summary.GetMean() / 1e3 << ',';
+			m_OutputStream << summary.Min / 1e3 << ',' << summary.Max / 1e3 << ',';
+			m_OutputStream << summary.GetPercentile(50.0) / 1e3 << ',' << summary.GetPercentile(90.0) / 1e3 << ',';
+			m_OutputStream << summary.GetPercentile(99.0) / 1e3 << ',' << summary.GetPercentile(99.9) / 1e3;
+
+			// Only MYGAME_PROFILE_SCOPE_COUNTERS sites have counters, the other rows leave them empty
+			if (summary.HasCounters())
+			{
+				m_OutputStream << ',' << summary.GetPerCall(summary.Cycles) << ',' << summary.GetIPC() << ',' << summary.GetPerCall(summary.CacheMisses) << ',';
+				m_OutputStream << summary.GetPerCall(summary.BranchMisses) << ',' << summary.GetPerCall(summary.ContextSwitches) << '\n';
+			}
+			else
+			{
+				m_OutputStream << ",,,,,\n";
+			}
+		}
+	}
+
+	// Note: you must already own lock on m_Mutex before calling CollectStatistics()
+	std::vector<ScopeSummary> Instrumentor::CollectStatistics()
+	{
+		std::unordered_map<uint32_t, ScopeSummary> summaries;
+		{
+			std::lock_guard lock(m_BuffersMutex);
+			for (auto& buffer : m_ThreadBuffers)
+				buffer->GetStatistics().ForEach(m_StatisticsGeneration, [&](uint32_t scopeID, const ScopeStatistics& statistics) { summaries[scopeID].Merge(statistics); });
+		}
+
+		std::vector<ScopeSummary> statistics;
+		std::lock_guard scopesLock(m_ScopesMutex);
+		for (auto& [scopeID, summary] : summaries)
+		{
+			if (!summary.Count)
+				continue;
+
+			auto it = m_ScopeNames.find(scopeID);
+			summary.ScopeID = scopeID;
+			summary.Name = it != m_ScopeNames.end() ? it->second : "<unknown>";
+			statistics.push_back(summary);
+		}
+
+		std::sort(statistics.begin(), statistics.end(), [](const ScopeSummary& a, const ScopeSummary& b) { return a.Total > b.Total; });
+		return statistics;
+	}
+
+	// Names of the threads known by the end of the session, viewers apply them to the whole trace
+	void Instrumentor::WriteThreadNames()
+	{
+		if (!IsTracing())
+			return;
+
+		std::lock_guard lock(m_BuffersMutex);
+		for (auto& buffer : m_ThreadBuffers)
+		{
+			const std::string& name = buffer->GetName();
+			if (name.empty())
+				continue;
+
+			if (m_CurrentSession->Binary)
+			{
+				const uint32_t threadIndex = WriteThread(buffer->GetThreadIndex(), buffer->GetThreadID());
+				TraceFile::Write(m_OutputStream, TraceFile::RecordType::ThreadName, TraceFile::ThreadNameRecord{ threadIndex, WriteName(TraceFile::HashName(name), name.c_str()) });
+			}
+			else
+			{
+				TraceFile::WriteChromeThreadName(m_OutputStream, buffer->GetThreadID(), name);
+			}
+		}
+	}
+
+	void Instrumentor::WriteFooter()
+	{
+		if (m_CurrentSession->Mode == InstrumentationMode::Statistics)
+		{
+			const std::vector<ScopeSummary> statistics = CollectStatistics();
+			WriteStatisticsRows(statistics);
+
+			if (Log::GetLogger())
+			{
+				for (size_t i = 0; i < std::min<size_t>(statistics.size(), 10); i++)
+				{
+					const ScopeSummary& summary = statistics[i];
+					MYGAME_INFO("{0}: {1} calls, {2:.3f} ms total, p50 {3:.1f} us, p99 {4:.1f} us, p99.9 {5:.1f} us, max {6:.1f} us", summary.Name, summary.Count, summary.Total / 1e6,
+						summary.GetPercentile(50.0) / 1e3, summary.GetPercentile(99.0) / 1e3, summary.GetPercentile(99.9) / 1e3, summary.Max / 1e3);
+				}
+			}
+		}
+		else if (!m_CurrentSession->Binary)
+			TraceFile::WriteChromeFooter(m_OutputStream);
+		m_OutputStream.flush();
+	}
+
+	void Instrumentor::InternalEndSession()
+	{
+		if (m_CurrentSession)
+		{
+			// Whatever got recorded since the writer's last wakeup
+			DrainBuffers();
+
+			WriteAllocations();
+			WriteThreadNames();
+			WriteFooter();
+			m_OutputStream.close();
+			delete m_CurrentSession;
+			m_CurrentSession = nullptr;
+		}
+	}
+}
@@ -1,27 +1,186 @@
 #pragma once
 
 #include "../Core/Log.h"
-
+#include "AllocationTracker.h"
+#include "PerfCounters.h"
+#include "ProfiledMutex.h"
+#include "ProfileScope.h"
+#include "ProfileStatistics.h"
+#include "ProfilerClock.h"
+#include "SamplingProfiler.h"
+#include "ThreadCpuTime.h"
+#include "TraceFile.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
-#include <iomanip>
+#include <memory>
 #include <thread>
 #include <mutex>
-#include <sstream>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace MyGame
 {
+	enum class ProfileResultType : uint8_t
+	{
+		Scope, Frame, Counter, FlowBegin, FlowEnd
+	};
+
+	// One per MYGAME_PROFILE_SCOPE_COUNTERS site: the scope, plus a counter track per metric named after it
+	struct ProfileCounterScope
+	{
+		ProfileScope Scope;
+		ProfileScope Cycles;
+		ProfileScope IPC;
+		ProfileScope CacheMisses;
+		ProfileScope BranchMisses;
+		ProfileScope ContextSwitches;
+	};
+
+	// Frames have no ProfileScope of their own
+	constexpr uint32_t FrameScopeID = TraceFile::HashName("Frame");
+
+	// Fixed-size record. Threads record ProfilerClock ticks, the writer converts
+	// them to steady_clock nanoseconds before anything else sees the record.
 	struct ProfileResult
 	{
-		std::string Name;
+		uint32_t ScopeID;
+		ProfileResultType Type = ProfileResultType::Scope;
+
+		int64_t Start;
+		union
+		{
+			int64_t ElapsedTime; // Scope, Frame
+			double Value;        // Counter, sampled at Start
+			uint64_t FlowID;     // FlowBegin, FlowEnd
+		};
+	};
 
-		std::chrono::duration<double, std::micro> Start;
-		std::chrono::microseconds ElapsedTime;
-		std::thread::id ThreadID;
+	// Handle of one piece of work handed from one thread to another (an event, an asset request,
+	// a recorded command buffer), see MYGAME_PROFILE_FLOW_BEGIN. Travels with the work, an ID of 0
+	// means nothing was capturing when it was submitted.
+	struct ProfileFlow
+	{
+		uint64_t ID = 0;
+		int64_t Start = 0;
+	};
+
+	enum class InstrumentationMode : uint8_t
+	{
+		// Every event goes into a Chrome JSON or binary trace
+		Trace,
+		// Only per-scope call counts, min/max and latency percentiles, written as CSV.
+		// Costs no memory over time, meant for soak tests.
+		Statistics
 	};
 
 	struct InstrumentationSession
 	{
 		std::string Name;
+		InstrumentationMode Mode = InstrumentationMode::Trace;
+		bool Binary = false;
+		int64_t Start = 0;
+	};
+
+	// Keeps the last FrameCount frames in memory and writes them out
+	// (as Chrome JSON) whenever a frame takes longer than ThresholdMs
+	struct HitchCaptureSettings
+	{
+		uint32_t FrameCount = 120;
+		uint32_t FramesAfter = 30;
+		float ThresholdMs = 50.0f;
+		std::string OutputDirectory = "Hitches";
+	};
+
+	struct ProfileThreadInfo
+	{
+		uint64_t ThreadID;
+		std::string Name; // Empty unless set with MYGAME_PROFILE_THREAD
+		uint32_t UtilizationScopeID; // Counter track of the thread's CPU utilization, 0 until the first frame
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t Index = 0;
+		int64_t Start = 0;
+		int64_t Duration = 0;
+		uint32_t ThreadIndex = 0;
+
+		struct Event
+		{
+			ProfileResult Result;
+			uint32_t ThreadIndex;
+			const char* Name;
+		};
+		std::vector<Event> Events;
+	};
+
+	// Single producer (owning thread), single consumer (writer thread) ring buffer.
+	class ProfileThreadBuffer
+	{
+	public:
+		static constexpr size_t Capacity = 1 << 14;
+
+		ProfileThreadBuffer(uint64_t threadID, uint32_t threadIndex) : m_ThreadID(threadID), m_ThreadIndex(threadIndex) {}
+
+		bool Push(const ProfileResult& result)
+		{
+			const size_t head = m_Head.load(std::memory_order_relaxed);
+			if (head - m_Tail.load(std::memory_order_acquire) == Capacity)
+			{
+				m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			m_Records[head & (Capacity - 1)] = result;
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		template<typename F>
+		size_t Drain(F&& func)
+		{
+			const size_t tail = m_Tail.load(std::memory_order_relaxed);
+			const size_t head = m_Head.load(std::memory_order_acquire);
+			for (size_t i = tail; i != head; i++)
+				func(m_Records[i & (Capacity - 1)]);
+
+			m_Tail.store(head, std::memory_order_release);
+			return head - tail;
+		}
+
+		// Consumer side only, throws away whatever is still pending
+		void Discard() { m_Tail.store(m_Head.load(std::memory_order_acquire), std::memory_order_release); }
+
+		uint64_t GetThreadID() const { return m_ThreadID; }
+		uint32_t GetThreadIndex() const { return m_ThreadIndex; }
+		uint64_t TakeDropped() { return m_Dropped.exchange(0, std::memory_order_relaxed); }
+
+		ScopeStatisticsTable& GetStatistics() { return m_Statistics; }
+
+		// Guarded by the Instrumentor's m_BuffersMutex
+		const std::string& GetName() const { return m_Name; }
+		void SetName(const std::string& name) { m_Name = name; }
+		uint32_t GetUtilizationScopeID() const { return m_UtilizationScopeID; }
+		void SetUtilizationScopeID(uint32_t scopeID) { m_UtilizationScopeID = scopeID; }
+
+	private:
+		std::array<ProfileResult, Capacity> m_Records;
+		ScopeStatisticsTable m_Statistics;
+
+		alignas(64) std::atomic<size_t> m_Head = 0;
+		alignas(64) std::atomic<size_t> m_Tail = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+		uint64_t m_ThreadID;
+		uint32_t m_ThreadIndex;
+		std::string m_Name;
+		uint32_t m_UtilizationScopeID = 0;
 	};
 
 	class Instrumentor
@@ -30,62 +189,165 @@ namespace MyGame
 		Instrumentor(const Instrumentor&) = delete;
 		Instrumentor(Instrumentor&&) = delete;
 
-		void BeginSession(const std::string& name, const std::string& filepath = "results.json")
+		// A filepath ending in .mgtrace writes the compact binary format, see TraceFile.h
+		void BeginSession(const std::string& name, const std::string& filepath = "results.json", InstrumentationMode mode = InstrumentationMode::Trace);
+		void EndSession();
+
+		// Statistics sessions only: appends the totals so far to the session's CSV, the same
+		// rows EndSession writes. Periodic snapshots show how percentiles drift over a long run.
+		void WriteStatistics();
+		std::vector<ScopeSummary> GetStatistics();
+		static bool IsCollectingStatistics() { return s_StatisticsGeneration.load(std::memory_order_relaxed) != 0; }
+
+		// Toggles a session at runtime, e.g. from a key binding in a Release build
+		void ToggleSession(const std::string& name, const std::string& filepath);
+		bool IsSessionActive();
+
+		// Can run on its own or next to a session, it only costs memory until a hitch is hit
+		void BeginHitchCapture(const HitchCaptureSettings& settings = HitchCaptureSettings());
+		void EndHitchCapture();
+
+		// Trace sessions also sample the call stacks of every profiled thread at this interval, which
+		// covers code without scopes (see SamplingProfiler). Zero, the default, turns sampling off,
+		// other intervals are clamped to SamplingProfiler::MinInterval.
+		void SetSamplingInterval(std::chrono::microseconds interval);
+
+		// MYGAME_PROFILE_SCOPE_COUNTERS sites only read the PerfCounters once this is enabled
+		// (--profile-counters or the profiler panel), until then they cost what a plain scope costs
+		static void SetPerfCountersEnabled(bool enabled) { s_ReadPerfCounters.store(enabled, std::memory_order_relaxed); }
+		static bool ArePerfCountersEnabled() { return s_ReadPerfCounters.load(std::memory_order_relaxed); }
+
+		// Keeps the last LiveFrameCount frames around for the in-game profiler panel
+		static constexpr uint32_t LiveFrameCount = 300;
+		void SetLiveCapture(bool enabled);
+		bool IsLiveCaptureEnabled();
+
+		// Appends every settled frame from firstIndex on and returns the index to continue from.
+		// The newest frames are held back for a bit, other threads may still add events to them.
+		uint64_t CopyFrameHistory(uint64_t firstIndex, std::vector<ProfileFrame>& frames);
+		std::vector<ProfileThreadInfo> GetThreads();
+
+		// Labels the calling thread in traces, the profiler panel and its utilization track
+		void SetThreadName(const std::string& name);
+
+		// True while anything consumes profiling data. This is the only thing a disabled
+		// scope pays for, so it is kept out of the singleton. Acquire so that the ProfilerClock
+		// calibration is visible to every thread that goes on to take timestamps.
+		static bool IsCapturing() { return s_Capturing.load(std::memory_order_acquire); }
+
+		// Called once per frame from Application::Run, closes the previous frame
+		void MarkFrame()
 		{
-			std::lock_guard lock(m_Mutex);
-			if (m_CurrentSession)
+			// Only frames that start while capturing are recorded, the clock may not be calibrated before
+			const int64_t now = ProfilerClock::Now();
+			const bool capturing = IsCapturing();
+			if (capturing && m_LastFrameStart)
 			{
-				// If there is already a current session, then close it before beginning new one.
-				// Subsequent profiling output meant for the original session will end up in the
-				// newly opened session instead.  That's better than having badly formatted
-				// profiling output.
+				WriteProfile({ FrameScopeID, ProfileResultType::Frame, m_LastFrameStart, now - m_LastFrameStart });
+				WriteThreadUtilization(m_LastFrameStart, now);
+			}
+			m_LastFrameStart = capturing ? now : 0;
 
-				if (Log::GetLogger()) // Edge case: BeginSession() might be before Log::Init()
-					MYGAME_ERROR("Instrumentor::BeginSession('{0}') when session '{1}' already open.", name, m_CurrentSession->Name);
+#ifdef MYGAME_TRACK_ALLOCATIONS
+			static constinit ProfileScope heapScope("Heap bytes live");
+			static constinit ProfileScope allocationsScope("Allocations per frame");
 
-				InternalEndSession();
-			}
-			m_OutputStream.open(filepath);
+			const uint64_t allocations = AllocationTracker::GetAllocationCount();
+			WriteCounter(heapScope, (double)AllocationTracker::GetLiveBytes());
+			WriteCounter(allocationsScope, (double)(allocations - m_LastAllocationCount));
+			m_LastAllocationCount = allocations;
+#endif
+		}
 
-			if (m_OutputStream.is_open())
-			{
-				m_CurrentSession = new InstrumentationSession({ name });
-				WriteHeader();
-			}
-			else
-			{
-				if (Log::GetLogger()) // Edge case: BeginSession() might be before Log::Init()
-					MYGAME_ERROR("Instrumentor could not open results file '{0}'.", filepath);
-			}
+		// Counters with the same name form one track, e.g. bytes uploaded or events dispatched
+		void WriteCounter(ProfileScope& scope, double value)
+		{
+			if (!IsCapturing())
+				return;
+			if (!scope.Registered.load(std::memory_order_acquire))
+				RegisterScope(scope);
+
+			ProfileResult result = { scope.ID, ProfileResultType::Counter, ProfilerClock::Now(), 0 };
+			result.Value = value;
+			WriteProfile(result);
 		}
 
-		void EndSession()
+		// Both ends are drawn as an arrow between the scopes enclosing them. Statistics sessions
+		// record the time from begin to end (the queueing latency) under the flow's name.
+		ProfileFlow BeginFlow(ProfileScope& scope)
 		{
-			std::lock_guard lock(m_Mutex);
-			InternalEndSession();
+			if (!IsCapturing())
+				return {};
+			if (!scope.Registered.load(std::memory_order_acquire))
+				RegisterScope(scope);
+
+			const ProfileFlow flow = { s_NextFlowID.fetch_add(1, std::memory_order_relaxed), ProfilerClock::Now() };
+			ProfileResult result = { scope.ID, ProfileResultType::FlowBegin, flow.Start, 0 };
+			result.FlowID = flow.ID;
+			WriteProfile(result);
+			return flow;
 		}
 
-		void WriteProfile(const ProfileResult& result)
+		void EndFlow(ProfileScope& scope, const ProfileFlow& flow)
+		{
+			if (!flow.ID || !IsCapturing())
+				return;
+			if (!scope.Registered.load(std::memory_order_acquire))
+				RegisterScope(scope);
+
+			const int64_t now = ProfilerClock::Now();
+			ProfileResult result = { scope.ID, ProfileResultType::FlowEnd, now, 0 };
+			result.FlowID = flow.ID;
+			WriteProfile(result);
+
+			if (const uint32_t generation = s_StatisticsGeneration.load(std::memory_order_relaxed))
+				GetThreadBuffer().GetStatistics().Add(scope.ID, ProfilerClock::ToFrameDuration(now - flow.Start), generation);
+		}
+
+		// Closes a MYGAME_PROFILE_SCOPE_COUNTERS scope: one sample per metric on the site's counter
+		// tracks, and per-scope totals for statistics sessions
+		void WritePerfCounters(ProfileCounterScope& scope, const PerfCounterValues& counters, int64_t timestamp)
 		{
-			std::stringstream json;
-
-			json << std::setprecision(3) << std::fixed;
-			json << ",{";
-			json << "\"cat\":\"function\",";
-			json << "\"dur\":" << (result.ElapsedTime.count()) << ',';
-			json << "\"name\":\"" << result.Name << "\",";
-			json << "\"ph\":\"X\",";
-			json << "\"pid\":0,";
-			json << "\"tid\":" << result.ThreadID << ",";
-			json << "\"ts\":" << result.Start.count();
-			json << "}";
-
-			std::lock_guard lock(m_Mutex);
-			if (m_CurrentSession)
+			if (const uint32_t generation = s_StatisticsGeneration.load(std::memory_order_relaxed))
+				GetThreadBuffer().GetStatistics().AddCounters(scope.Scope.ID, counters, generation);
+			if (!s_RecordingEvents.load(std::memory_order_relaxed))
+				return;
+
+			auto write = [&](ProfileScope& track, double value)
+			{
+				if (!track.Registered.load(std::memory_order_acquire))
+					RegisterScope(track);
+
+				ProfileResult result = { track.ID, ProfileResultType::Counter, timestamp, 0 };
+				result.Value = value;
+				WriteProfile(result);
+			};
+			write(scope.Cycles, (double)counters.Cycles);
+			if (counters.HasHardwareCounters)
 			{
-				m_OutputStream << json.str();
-				m_OutputStream.flush();
+				write(scope.IPC, counters.GetIPC());
+				write(scope.CacheMisses, (double)counters.CacheMisses);
+				write(scope.BranchMisses, (double)counters.BranchMisses);
 			}
+			if (counters.HasContextSwitches)
+				write(scope.ContextSwitches, (double)counters.ContextSwitches);
+		}
+
+		// Makes the scope's name known to the writer, must happen before its first record is pushed
+		void RegisterScope(ProfileScope& scope);
+
+		// Lock-free unless this is the first event recorded on the calling thread
+		void WriteProfile(const ProfileResult& result)
+		{
+			ProfileThreadBuffer& buffer = GetThreadBuffer();
+			if (s_RecordingEvents.load(std::memory_order_relaxed))
+				buffer.Push(result);
+
+			const uint32_t generation = s_StatisticsGeneration.load(std::memory_order_relaxed);
+			if (generation && result.Type == ProfileResultType::Scope)
+				buffer.GetStatistics().Add(result.ScopeID, ProfilerClock::ToDuration(result.ElapsedTime), generation);
+			else if (generation && result.Type == ProfileResultType::Frame)
+				buffer.GetStatistics().Add(result.ScopeID, ProfilerClock::ToFrameDuration(result.ElapsedTime), generation);
 		}
 
 		static Instrumentor& Get()
@@ -95,60 +357,188 @@ namespace MyGame
 		}
 
 	private:
-		Instrumentor() : m_CurrentSession(nullptr) {}
-		~Instrumentor() { EndSession(); }
-
-		void WriteHeader()
+		Instrumentor() : m_CurrentSession(nullptr)
+		{
+			m_ScopeNames[FrameScopeID] = "Frame";
+		}
+		~Instrumentor()
 		{
-			m_OutputStream << "{\"otherData\": {},\"traceEvents\":[{}";
-			m_OutputStream.flush();
+			EndSession();
+			EndHitchCapture();
+			for (ThreadUtilization& thread : m_ThreadUtilization)
+				ThreadCpuTime::Close(thread.Handle);
 		}
 
-		void WriteFooter()
+		ProfileThreadBuffer* RegisterThread();
+		ProfileThreadBuffer& GetThreadBuffer()
 		{
-			m_OutputStream << "]}";
-			m_OutputStream.flush();
+			static thread_local ProfileThreadBuffer* buffer = RegisterThread();
+			return *buffer;
 		}
 
+		// Starts or stops the writer thread depending on whether anything still consumes
+		// data. Callers hold m_ControlMutex but not m_Mutex, the writer needs that one.
+		void UpdateCapturing();
+
+		bool IsTracing() const { return m_CurrentSession && m_CurrentSession->Mode == InstrumentationMode::Trace; }
+
+		void WriterThread();
+		void DrainBuffers();
+		const char* GetScopeName(const ProfileResult& result) const;
+		void WriteRecord(const ProfileResult& result, const char* name, const ProfileThreadBuffer& buffer);
+		void WriteSample(const SamplingProfiler::Sample& sample);
+		uint32_t WriteThread(uint32_t threadIndex, uint64_t threadID);
+		uint32_t WriteName(uint32_t nameID, const char* name);
+
+		bool KeepsFrameHistory() const { return m_HitchCapture || m_LiveCapture; }
+		void UpdateFrameHistory(std::vector<ProfileFrame::Event>& events);
+		void DumpFrameHistory(const ProfileFrame& hitch);
+
+		void WriteHeader();
+		void WriteAllocations();
+		void WriteStatisticsRows(const std::vector<ScopeSummary>& statistics);
+		void WriteThreadNames();
+		void WriteFooter();
+
+		void WriteThreadUtilization(int64_t frameStart, int64_t frameEnd);
+
+		// Note: you must already own lock on m_Mutex before calling CollectStatistics()
+		std::vector<ScopeSummary> CollectStatistics();
+
 		// Note: you must already own lock on m_Mutex before
 		// calling InternalEndSession()
-		void InternalEndSession()
-		{
-			if (m_CurrentSession)
-			{
-				WriteFooter();
-				m_OutputStream.close();
-				delete m_CurrentSession;
-				m_CurrentSession = nullptr;
-			}
-		}
+		void InternalEndSession();
 
 	private:
+		// Lock order is m_ControlMutex, m_Mutex, m_BuffersMutex, m_ScopesMutex
+		std::mutex m_ControlMutex;
+
 		InstrumentationSession* m_CurrentSession;
 		std::ofstream m_OutputStream;
-		std::mutex m_Mutex;
+		ProfiledMutex m_Mutex{ MYGAME_LOCK_SITE("Instrumentor::m_Mutex") };
+
+		SamplingProfiler m_Sampler;
+		std::chrono::microseconds m_SamplingInterval{ 0 };
+
+		// Every registered scope by ID, never cleared since the sites are static
+		std::unordered_map<uint32_t, const char*> m_ScopeNames;
+		// Nothing may log or take a ProfiledMutex while holding it, either can register a scope
+		std::mutex m_ScopesMutex;
+
+		// Binary sessions only, owned by the writer thread
+		std::unordered_set<uint32_t> m_NamesWritten;
+		std::vector<bool> m_ThreadsWritten;
+
+		// Frame history for hitch and live capture, guarded by m_Mutex
+		std::optional<HitchCaptureSettings> m_HitchCapture;
+		bool m_LiveCapture = false;
+		std::deque<ProfileFrame> m_Frames;
+		std::vector<ProfileFrame::Event> m_PendingEvents;
+		uint64_t m_FrameIndex = 0;
+		uint64_t m_HitchDumpFrame = 0;
+		std::optional<ProfileFrame> m_Hitch;
+
+		// Main thread only
+		int64_t m_LastFrameStart = 0;
+		struct ThreadUtilization
+		{
+			std::string Name;
+			std::unique_ptr<ProfileScope> Scope;
+			void* Handle = nullptr;
+			int64_t LastCpuTime = 0;
+		};
+		std::deque<ThreadUtilization> m_ThreadUtilization; // By thread index, never moves since scopes point into it
+		int64_t m_LastUtilizationFrameEnd = 0;
+#ifdef MYGAME_TRACK_ALLOCATIONS
+		uint64_t m_LastAllocationCount = 0;
+#endif
+
+		inline static std::atomic<bool> s_Capturing = false;
+		// Trace sessions and frame history, the per-thread ring buffers only fill while this is set
+		inline static std::atomic<bool> s_RecordingEvents = false;
+		// Non-zero while a statistics session runs, a new value per session so threads reset their tables
+		inline static std::atomic<uint32_t> s_StatisticsGeneration = 0;
+		inline static std::atomic<uint64_t> s_NextFlowID = 1;
+		inline static std::atomic<bool> s_ReadPerfCounters = false;
+		uint32_t m_StatisticsGeneration = 0;
+		std::vector<std::unique_ptr<ProfileThreadBuffer>> m_ThreadBuffers;
+		std::mutex m_BuffersMutex;
+
+		std::thread m_Writer;
+		std::mutex m_WriterMutex;
+		std::condition_variable m_WriterWakeup;
+		bool m_WriterRunning = false;
 	};
 
 	class InstrumentationTimer
 	{
 	public:
-		InstrumentationTimer(const char* name) : m_Name(name), m_Stopped(false) { m_StartTimepoint = std::chrono::steady_clock::now(); }
-		~InstrumentationTimer() { if (!m_Stopped) Stop(); }
+		InstrumentationTimer(ProfileScope& scope) : m_Scope(scope), m_Stopped(!Instrumentor::IsCapturing())
+		{
+			if (!m_Stopped)
+				m_Start = ProfilerClock::Now();
+#ifdef MYGAME_TRACK_ALLOCATIONS
+			m_PreviousAllocationScope = AllocationTracker::SetScope(scope.Name);
+#endif
+		}
+
+		~InstrumentationTimer()
+		{
+			if (!m_Stopped)
+				Stop();
+#ifdef MYGAME_TRACK_ALLOCATIONS
+			AllocationTracker::SetScope(m_PreviousAllocationScope);
+#endif
+		}
 
 		void Stop()
 		{
-			auto endTimepoint = std::chrono::steady_clock::now();
-			auto highResStart = std::chrono::duration<double, std::micro>{ m_StartTimepoint.time_since_epoch() };
-			auto elapsedTime = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch() - std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch();
+			const int64_t elapsedTime = ProfilerClock::Now() - m_Start;
 
-			Instrumentor::Get().WriteProfile({ m_Name, highResStart, elapsedTime, std::this_thread::get_id() });
+			if (!m_Scope.Registered.load(std::memory_order_acquire))
+				Instrumentor::Get().RegisterScope(m_Scope);
+			Instrumentor::Get().WriteProfile({ m_Scope.ID, ProfileResultType::Scope, m_Start, elapsedTime });
 			m_Stopped = true;
 		}
 
+		bool IsRunning() const { return !m_Stopped; }
+
 	private:
-		const char* m_Name;
-		std::chrono::time_point<std::chrono::steady_clock> m_StartTimepoint;
+		ProfileScope& m_Scope;
+		int64_t m_Start = 0;
 		bool m_Stopped;
+#ifdef MYGAME_TRACK_ALLOCATIONS
+		const char* m_PreviousAllocationScope;
+#endif
+	};
+
+	// InstrumentationTimer that also reads PerfCounters around the scope. A read costs far more than a
+	// timestamp, so only put these on scopes under investigation. The reads stay outside the timed part.
+	class CountedInstrumentationTimer
+	{
+	public:
+		CountedInstrumentationTimer(ProfileCounterScope& scope)
+			: m_Scope(scope), m_Begin(Instrumentor::IsCapturing() && Instrumentor::ArePerfCountersEnabled() ? std::optional(PerfCounters::Read()) : std::nullopt), m_Timer(scope.Scope)
+		{
+		}
+
+		~CountedInstrumentationTimer()
+		{
+			if (!m_Timer.IsRunning())
+				return;
+
+			m_Timer.Stop();
+			if (m_Begin)
+				Instrumentor::Get().WritePerfCounters(m_Scope, PerfCounters::Read() - *m_Begin, ProfilerClock::Now());
+		}
+
+		CountedInstrumentationTimer(const CountedInstrumentationTimer&) = delete;
+		CountedInstrumentationTimer& operator=(const CountedInstrumentationTimer&) = delete;
+
+	private:
+		ProfileCounterScope& m_Scope;
+		std::optional<PerfCounterValues> m_Begin;
+		InstrumentationTimer m_Timer;
 	};
 
 	namespace InstrumentorUtilities
@@ -178,11 +568,33 @@ namespace MyGame
 			}
 			return result;
 		}
+
+		// Names of the counter tracks of a MYGAME_PROFILE_SCOPE_COUNTERS site
+		template <size_t N, size_t K>
+		constexpr auto AppendString(const char(&expr)[N], const char(&suffix)[K])
+		{
+			ChangeResult<N + K - 1> result = {};
+
+			size_t dstIndex = 0;
+			for (size_t srcIndex = 0; srcIndex < N && expr[srcIndex]; srcIndex++)
+				result.Data[dstIndex++] = expr[srcIndex];
+			for (size_t srcIndex = 0; srcIndex < K; srcIndex++)
+				result.Data[dstIndex++] = suffix[srcIndex];
+			return result;
+		}
 	}
 }
 
 
-#if MYGAME_DEBUG
+// Profiling is compiled in for Debug builds and for any build defining MYGAME_ENABLE_PROFILING
+// (Release does). Every scope then costs a single branch while no session is running.
+#if defined(MYGAME_DEBUG) || defined(MYGAME_ENABLE_PROFILING)
+#define MYGAME_PROFILE 1
+#else
+#define MYGAME_PROFILE 0
+#endif
+
+#if MYGAME_PROFILE
 
 // Resolve which function signature macro will be used. Note that this only
 // is resolved when the (pre)compiler starts, so the syntax highlighting
@@ -206,19 +618,60 @@ namespace MyGame
 #define MYGAME_FUNC_SIG "MYGAME_FUNC_SIG unknown!"
 #endif
 
+// The cleaned name and its ProfileScope are static and constant initialized, so a site costs no guard or
+// lookup at runtime. Records only carry the scope's ID, the writer resolves names from the registered scopes.
 #define MYGAME_PROFILE_BEGIN_SESSION(name, filepath) ::MyGame::Instrumentor::Get().BeginSession(name, filepath)
+#define MYGAME_PROFILE_BEGIN_STATISTICS_SESSION(name, filepath) ::MyGame::Instrumentor::Get().BeginSession(name, filepath, ::MyGame::InstrumentationMode::Statistics)
 #define MYGAME_PROFILE_END_SESSION() ::MyGame::Instrumentor::Get().EndSession()
-#define MYGAME_PROFILE_SCOPE_LINE2(name, line) constexpr auto fixedName##line = ::MyGame::InstrumentorUtilities::CleanupOutputString(name, "__cdecl ");\
-											   ::MyGame::InstrumentationTimer timer##line(fixedName##line.Data)
+#define MYGAME_PROFILE_WRITE_STATISTICS() ::MyGame::Instrumentor::Get().WriteStatistics()
+#define MYGAME_PROFILE_TOGGLE_SESSION(name, filepath) ::MyGame::Instrumentor::Get().ToggleSession(name, filepath)
+#define MYGAME_PROFILE_BEGIN_HITCH_CAPTURE(settings) ::MyGame::Instrumentor::Get().BeginHitchCapture(settings)
+#define MYGAME_PROFILE_END_HITCH_CAPTURE() ::MyGame::Instrumentor::Get().EndHitchCapture()
+#define MYGAME_PROFILE_SET_SAMPLING_INTERVAL(interval) ::MyGame::Instrumentor::Get().SetSamplingInterval(interval)
+#define MYGAME_PROFILE_SET_PERF_COUNTERS(enabled) ::MyGame::Instrumentor::SetPerfCountersEnabled(enabled)
+#define MYGAME_PROFILE_FRAME_MARK() ::MyGame::Instrumentor::Get().MarkFrame()
+#define MYGAME_PROFILE_THREAD(name) ::MyGame::Instrumentor::Get().SetThreadName(name)
+#define MYGAME_PROFILE_COUNTER(name, value) do { static constinit ::MyGame::ProfileScope counterScope(name); ::MyGame::Instrumentor::Get().WriteCounter(counterScope, (double)(value)); } while (false)
+#define MYGAME_PROFILE_FLOW_BEGIN(flow, name) do { static constinit ::MyGame::ProfileScope flowScope(name); (flow) = ::MyGame::Instrumentor::Get().BeginFlow(flowScope); } while (false)
+#define MYGAME_PROFILE_FLOW_END(flow, name) do { static constinit ::MyGame::ProfileScope flowScope(name); ::MyGame::Instrumentor::Get().EndFlow(flowScope, flow); } while (false)
+#define MYGAME_PROFILE_SCOPE_LINE2(name, line) static constexpr auto fixedName##line = ::MyGame::InstrumentorUtilities::CleanupOutputString(name, "__cdecl ");\
+											   static constinit ::MyGame::ProfileScope scope##line(fixedName##line.Data);\
+											   ::MyGame::InstrumentationTimer timer##line(scope##line)
 #define MYGAME_PROFILE_SCOPE_LINE(name, line) MYGAME_PROFILE_SCOPE_LINE2(name, line)
 #define MYGAME_PROFILE_SCOPE(name) MYGAME_PROFILE_SCOPE_LINE(name, __LINE__)
 #define MYGAME_PROFILE_FUNCTION() MYGAME_PROFILE_SCOPE(MYGAME_FUNC_SIG)
+#define MYGAME_PROFILE_SCOPE_COUNTERS_LINE2(name, line) static constexpr auto fixedName##line = ::MyGame::InstrumentorUtilities::CleanupOutputString(name, "__cdecl ");\
+														static constexpr auto cyclesName##line = ::MyGame::InstrumentorUtilities::AppendString(fixedName##line.Data, " (cycles)");\
+														static constexpr auto ipcName##line = ::MyGame::InstrumentorUtilities::AppendString(fixedName##line.Data, " (IPC)");\
+														static constexpr auto cacheMissesName##line = ::MyGame::InstrumentorUtilities::AppendString(fixedName##line.Data, " (cache misses)");\
+														static constexpr auto branchMissesName##line = ::MyGame::InstrumentorUtilities::AppendString(fixedName##line.Data, " (branch misses)");\
+														static constexpr auto contextSwitchesName##line = ::MyGame::InstrumentorUtilities::AppendString(fixedName##line.Data, " (context switches)");\
+														static constinit ::MyGame::ProfileCounterScope scope##line{ fixedName##line.Data, cyclesName##line.Data, ipcName##line.Data,\
+															cacheMissesName##line.Data, branchMissesName##line.Data, contextSwitchesName##line.Data };\
+														::MyGame::CountedInstrumentationTimer timer##line(scope##line)
+#define MYGAME_PROFILE_SCOPE_COUNTERS_LINE(name, line) MYGAME_PROFILE_SCOPE_COUNTERS_LINE2(name, line)
+#define MYGAME_PROFILE_SCOPE_COUNTERS(name) MYGAME_PROFILE_SCOPE_COUNTERS_LINE(name, __LINE__)
+#define MYGAME_PROFILE_FUNCTION_COUNTERS() MYGAME_PROFILE_SCOPE_COUNTERS(MYGAME_FUNC_SIG)
 
 #else
 
 #define MYGAME_PROFILE_BEGIN_SESSION(name, filepath)
+#define MYGAME_PROFILE_BEGIN_STATISTICS_SESSION(name, filepath)
 #define MYGAME_PROFILE_END_SESSION()
+#define MYGAME_PROFILE_WRITE_STATISTICS()
+#define MYGAME_PROFILE_TOGGLE_SESSION(name, filepath)
+#define MYGAME_PROFILE_BEGIN_HITCH_CAPTURE(settings)
+#define MYGAME_PROFILE_END_HITCH_CAPTURE()
+#define MYGAME_PROFILE_SET_SAMPLING_INTERVAL(interval)
+#define MYGAME_PROFILE_SET_PERF_COUNTERS(enabled)
+#define MYGAME_PROFILE_FRAME_MARK()
+#define MYGAME_PROFILE_THREAD(name)
+#define MYGAME_PROFILE_COUNTER(name, value)
+#define MYGAME_PROFILE_FLOW_BEGIN(flow, name)
+#define MYGAME_PROFILE_FLOW_END(flow, name)
 #define MYGAME_PROFILE_SCOPE(name)
 #define MYGAME_PROFILE_FUNCTION()
+#define MYGAME_PROFILE_SCOPE_COUNTERS(name)
+#define MYGAME_PROFILE_FUNCTION_COUNTERS()
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MyGame
+{
+	// Per-thread hardware and scheduler counters, read at the begin and end of a
+	// MYGAME_PROFILE_SCOPE_COUNTERS scope. Values only grow, a scope reports the difference.
+	struct PerfCounterValues
+	{
+		uint64_t Cycles = 0;     // Reference cycles, they tick at the TSC rate whatever the core's clock
+		uint64_t CoreCycles = 0; // Unhalted core clock cycles
+		uint64_t Instructions = 0;
+		uint64_t CacheMisses = 0;
+		uint64_t BranchMisses = 0;
+		uint64_t ContextSwitches = 0;
+
+		// Without them only Cycles is meaningful
+		bool HasHardwareCounters = false;
+		bool HasContextSwitches = false;
+
+		PerfCounterValues operator-(const PerfCounterValues& other) const
+		{
+			return { Cycles - other.Cycles, CoreCycles - other.CoreCycles, Instructions - other.Instructions, CacheMisses - other.CacheMisses, BranchMisses - other.BranchMisses,
+				ContextSwitches - other.ContextSwitches, HasHardwareCounters && other.HasHardwareCounters, HasContextSwitches && other.HasContextSwitches };
+		}
+
+		// Per core cycle, reference cycles would skew it by the turbo or power saving clock ratio
+		double GetIPC() const { return CoreCycles && Instructions ? (double)Instructions / CoreCycles : 0.0; }
+	};
+
+	class PerfCounters
+	{
+	public:
+		// Counters of the calling thread. The first call on a thread sets up its profiling
+		// context; when that is not available only the thread's cycle time is read.
+		static PerfCounterValues Read();
+	};
+}
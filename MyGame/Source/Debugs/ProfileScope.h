@@ -0,0 +1,20 @@
+#pragma once
+
+#include "TraceFile.h"
+
+#include <atomic>
+
+namespace MyGame
+{
+	// One per MYGAME_PROFILE_SCOPE / FUNCTION / COUNTER site. The ID is a hash of the name, so it
+	// stays the same across builds and sessions. The name is registered the first time the site
+	// records something, records only carry the ID.
+	struct ProfileScope
+	{
+		const char* Name;
+		uint32_t ID;
+		std::atomic<bool> Registered = false;
+
+		constexpr ProfileScope(const char* name) : Name(name), ID(TraceFile::HashName(name)) {}
+	};
+}
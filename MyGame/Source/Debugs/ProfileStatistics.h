@@ -0,0 +1,236 @@
+#pragma once
+
+#include "PerfCounters.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+namespace MyGame
+{
+	// Log-bucketed durations: 4 buckets per power of two (12.5% wide at most),
+	// covering 0 ns up to 2^48 ns (~78 hours)
+	namespace LatencyHistogram
+	{
+		constexpr uint32_t SubBucketBits = 2;
+		constexpr uint32_t SubBuckets = 1 << SubBucketBits;
+		constexpr uint32_t MaxExponent = 47;
+		constexpr uint32_t BucketCount = SubBuckets * (MaxExponent - SubBucketBits + 2);
+
+		constexpr uint32_t GetBucket(uint64_t duration)
+		{
+			if (duration < SubBuckets)
+				return (uint32_t)duration;
+
+			const uint32_t exponent = std::min<uint32_t>((uint32_t)std::bit_width(duration) - 1, MaxExponent);
+			const uint64_t subBucket = std::min<uint64_t>((duration >> (exponent - SubBucketBits)) - SubBuckets, SubBuckets - 1);
+			return SubBuckets * (exponent - SubBucketBits + 1) + (uint32_t)subBucket;
+		}
+
+		constexpr uint64_t GetBucketStart(uint32_t bucket)
+		{
+			if (bucket < SubBuckets)
+				return bucket;
+
+			const uint32_t exponent = bucket / SubBuckets + SubBucketBits - 1;
+			return (uint64_t)(SubBuckets + bucket % SubBuckets) << (exponent - SubBucketBits);
+		}
+
+		static_assert(GetBucket(GetBucketStart(BucketCount - 1)) == BucketCount - 1);
+	}
+
+	// Accumulators of one scope site on one thread. Only the owning thread writes,
+	// so updates are plain load + store; other threads may read at any time.
+	struct ScopeStatistics
+	{
+		std::atomic<uint64_t> Count = 0;
+		std::atomic<uint64_t> Total = 0;
+		std::atomic<uint64_t> Min = UINT64_MAX;
+		std::atomic<uint64_t> Max = 0;
+		std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount> Buckets = {};
+
+		// Totals of MYGAME_PROFILE_SCOPE_COUNTERS sites, zero for other scopes
+		std::atomic<uint64_t> Cycles = 0;
+		std::atomic<uint64_t> CoreCycles = 0;
+		std::atomic<uint64_t> Instructions = 0;
+		std::atomic<uint64_t> CacheMisses = 0;
+		std::atomic<uint64_t> BranchMisses = 0;
+		std::atomic<uint64_t> ContextSwitches = 0;
+
+		void Add(uint64_t duration)
+		{
+			Increment(Count, 1);
+			Increment(Total, duration);
+			if (duration < Min.load(std::memory_order_relaxed))
+				Min.store(duration, std::memory_order_relaxed);
+			if (duration > Max.load(std::memory_order_relaxed))
+				Max.store(duration, std::memory_order_relaxed);
+			Increment(Buckets[LatencyHistogram::GetBucket(duration)], 1);
+		}
+
+		void AddCounters(const PerfCounterValues& counters)
+		{
+			Increment(Cycles, counters.Cycles);
+			Increment(CoreCycles, counters.CoreCycles);
+			Increment(Instructions, counters.Instructions);
+			Increment(CacheMisses, counters.CacheMisses);
+			Increment(BranchMisses, counters.BranchMisses);
+			Increment(ContextSwitches, counters.ContextSwitches);
+		}
+
+		void Reset()
+		{
+			Count.store(0, std::memory_order_relaxed);
+			Total.store(0, std::memory_order_relaxed);
+			Min.store(UINT64_MAX, std::memory_order_relaxed);
+			Max.store(0, std::memory_order_relaxed);
+			for (auto& bucket : Buckets)
+				bucket.store(0, std::memory_order_relaxed);
+			for (auto* counter : { &Cycles, &CoreCycles, &Instructions, &CacheMisses, &BranchMisses, &ContextSwitches })
+				counter->store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static void Increment(std::atomic<uint64_t>& value, uint64_t amount) { value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+	};
+
+	// Per-thread scope ID -> ScopeStatistics map. Only the owning thread inserts, and entries
+	// are never removed, so readers only need the acquire on the slot's ID.
+	class ScopeStatisticsTable
+	{
+	public:
+		static constexpr size_t Capacity = 1024;
+
+		// Owning thread only. A new generation means a new statistics session, stale values are cleared first.
+		void Add(uint32_t scopeID, uint64_t duration, uint32_t generation)
+		{
+			if (ScopeStatistics* statistics = Find(scopeID, generation))
+				statistics->Add(duration);
+		}
+
+		void AddCounters(uint32_t scopeID, const PerfCounterValues& counters, uint32_t generation)
+		{
+			if (ScopeStatistics* statistics = Find(scopeID, generation))
+				statistics->AddCounters(counters);
+		}
+
+		template<typename F>
+		void ForEach(uint32_t generation, F&& func) const
+		{
+			if (m_Generation.load(std::memory_order_acquire) != generation)
+				return;
+
+			for (const Slot& slot : m_Slots)
+			{
+				if (const uint32_t scopeID = slot.ScopeID.load(std::memory_order_acquire))
+					func(scopeID, *slot.Statistics);
+			}
+		}
+
+	private:
+		ScopeStatistics* Find(uint32_t scopeID, uint32_t generation)
+		{
+			if (generation != m_Generation.load(std::memory_order_relaxed))
+			{
+				for (Slot& slot : m_Slots)
+					if (slot.ScopeID.load(std::memory_order_relaxed))
+						slot.Statistics->Reset();
+				m_Generation.store(generation, std::memory_order_release);
+			}
+
+			size_t index = scopeID & (Capacity - 1);
+			for (size_t probe = 0; probe < Capacity; probe++, index = (index + 1) & (Capacity - 1))
+			{
+				Slot& slot = m_Slots[index];
+				const uint32_t current = slot.ScopeID.load(std::memory_order_relaxed);
+				if (current == scopeID)
+					return slot.Statistics.get();
+
+				if (!current)
+				{
+					slot.Statistics = std::make_unique<ScopeStatistics>();
+					slot.ScopeID.store(scopeID, std::memory_order_release);
+					return slot.Statistics.get();
+				}
+			}
+			return nullptr;
+		}
+
+	private:
+		struct Slot
+		{
+			std::atomic<uint32_t> ScopeID = 0;
+			std::unique_ptr<ScopeStatistics> Statistics;
+		};
+
+		std::array<Slot, Capacity> m_Slots;
+		std::atomic<uint32_t> m_Generation = 0;
+	};
+
+	// All threads of one scope site merged, durations are nanoseconds
+	struct ScopeSummary
+	{
+		uint32_t ScopeID = 0;
+		const char* Name = nullptr;
+		uint64_t Count = 0;
+		uint64_t Total = 0;
+		uint64_t Min = UINT64_MAX;
+		uint64_t Max = 0;
+		std::array<uint64_t, LatencyHistogram::BucketCount> Buckets = {};
+		uint64_t Cycles = 0;
+		uint64_t CoreCycles = 0;
+		uint64_t Instructions = 0;
+		uint64_t CacheMisses = 0;
+		uint64_t BranchMisses = 0;
+		uint64_t ContextSwitches = 0;
+
+		void Merge(const ScopeStatistics& statistics)
+		{
+			Count += statistics.Count.load(std::memory_order_relaxed);
+			Total += statistics.Total.load(std::memory_order_relaxed);
+			Min = std::min(Min, statistics.Min.load(std::memory_order_relaxed));
+			Max = std::max(Max, statistics.Max.load(std::memory_order_relaxed));
+			for (uint32_t i = 0; i < LatencyHistogram::BucketCount; i++)
+				Buckets[i] += statistics.Buckets[i].load(std::memory_order_relaxed);
+			Cycles += statistics.Cycles.load(std::memory_order_relaxed);
+			CoreCycles += statistics.CoreCycles.load(std::memory_order_relaxed);
+			Instructions += statistics.Instructions.load(std::memory_order_relaxed);
+			CacheMisses += statistics.CacheMisses.load(std::memory_order_relaxed);
+			BranchMisses += statistics.BranchMisses.load(std::memory_order_relaxed);
+			ContextSwitches += statistics.ContextSwitches.load(std::memory_order_relaxed);
+		}
+
+		// Midpoint of the bucket holding the given percentile (0-100), clamped to the observed range
+		uint64_t GetPercentile(double percentile) const
+		{
+			uint64_t histogramCount = 0;
+			for (uint64_t bucket : Buckets)
+				histogramCount += bucket;
+			if (!histogramCount)
+				return 0;
+
+			const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(percentile / 100.0 * histogramCount + 0.5));
+			uint64_t seen = 0;
+			for (uint32_t i = 0; i < LatencyHistogram::BucketCount; i++)
+			{
+				seen += Buckets[i];
+				if (seen >= rank)
+				{
+					const uint64_t start = LatencyHistogram::GetBucketStart(i);
+					const uint64_t end = i + 1 < LatencyHistogram::BucketCount ? LatencyHistogram::GetBucketStart(i + 1) : start + 1;
+					return std::min(std::max(start + (end - start) / 2, Min), Max);
+				}
+			}
+			return Max;
+		}
+
+		double GetMean() const { return Count ? (double)Total / Count : 0.0; }
+
+		bool HasCounters() const { return Cycles != 0; }
+		double GetIPC() const { return CoreCycles ? (double)Instructions / CoreCycles : 0.0; }
+		double GetPerCall(uint64_t total) const { return Count ? (double)total / Count : 0.0; }
+	};
+}
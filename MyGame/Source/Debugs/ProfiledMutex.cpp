@@ -0,0 +1,143 @@
+#include "CommonHeaders.h"
+
+#include "ProfiledMutex.h"
+#include "Instrumentor.h"
+
+namespace MyGame
+{
+	// Shared owners can't keep their lock time in the mutex, every thread tracks the few it holds
+	struct SharedHold
+	{
+		const void* Mutex;
+		int64_t LockedAt;
+	};
+	static thread_local std::array<SharedHold, 8> s_SharedHolds = {};
+
+	static void WriteScope(ProfileScope& scope, int64_t start, int64_t end)
+	{
+		Instrumentor& instrumentor = Instrumentor::Get();
+		if (!scope.Registered.load(std::memory_order_acquire))
+			instrumentor.RegisterScope(scope);
+		instrumentor.WriteProfile({ scope.ID, ProfileResultType::Scope, start, end - start });
+	}
+
+	// Returns when the lock was acquired, 0 if nothing captures
+	template<typename TryLock, typename Lock>
+	static int64_t LockProfiled(ProfileLockSite& site, TryLock&& tryLock, Lock&& lock)
+	{
+		if (!Instrumentor::IsCapturing())
+		{
+			lock();
+			return 0;
+		}
+
+		if (tryLock())
+			return ProfilerClock::Now();
+
+		const int64_t waitStart = ProfilerClock::Now();
+		lock();
+		const int64_t lockedAt = ProfilerClock::Now();
+
+		WriteScope(site.Wait, waitStart, lockedAt);
+		Instrumentor::Get().WriteCounter(site.Contentions, (double)(site.ContentionCount.fetch_add(1, std::memory_order_relaxed) + 1));
+		return lockedAt;
+	}
+
+	static void WriteHold(ProfileLockSite& site, int64_t lockedAt)
+	{
+		if (lockedAt && Instrumentor::IsCapturing())
+			WriteScope(site.Hold, lockedAt, ProfilerClock::Now());
+	}
+
+	static void AddSharedHold(const void* mutex, int64_t lockedAt)
+	{
+		if (!lockedAt)
+			return;
+
+		for (SharedHold& hold : s_SharedHolds)
+		{
+			if (!hold.Mutex)
+			{
+				hold = { mutex, lockedAt };
+				return;
+			}
+		}
+	}
+
+	static int64_t RemoveSharedHold(const void* mutex)
+	{
+		for (SharedHold& hold : s_SharedHolds)
+		{
+			if (hold.Mutex == mutex)
+			{
+				hold.Mutex = nullptr;
+				return hold.LockedAt;
+			}
+		}
+		return 0;
+	}
+
+	void ProfiledMutex::lock()
+	{
+		m_LockedAt = LockProfiled(m_Site, [this] { return m_Mutex.try_lock(); }, [this] { m_Mutex.lock(); });
+	}
+
+	bool ProfiledMutex::try_lock()
+	{
+		if (!m_Mutex.try_lock())
+			return false;
+
+		m_LockedAt = Instrumentor::IsCapturing() ? ProfilerClock::Now() : 0;
+		return true;
+	}
+
+	void ProfiledMutex::unlock()
+	{
+		// The record is written after the unlock so it doesn't lengthen the hold
+		const int64_t lockedAt = m_LockedAt;
+		m_Mutex.unlock();
+		WriteHold(m_Site, lockedAt);
+	}
+
+	void ProfiledSharedMutex::lock()
+	{
+		m_LockedAt = LockProfiled(m_Site, [this] { return m_Mutex.try_lock(); }, [this] { m_Mutex.lock(); });
+	}
+
+	bool ProfiledSharedMutex::try_lock()
+	{
+		if (!m_Mutex.try_lock())
+			return false;
+
+		m_LockedAt = Instrumentor::IsCapturing() ? ProfilerClock::Now() : 0;
+		return true;
+	}
+
+	void ProfiledSharedMutex::unlock()
+	{
+		const int64_t lockedAt = m_LockedAt;
+		m_Mutex.unlock();
+		WriteHold(m_Site, lockedAt);
+	}
+
+	void ProfiledSharedMutex::lock_shared()
+	{
+		AddSharedHold(this, LockProfiled(m_Site, [this] { return m_Mutex.try_lock_shared(); }, [this] { m_Mutex.lock_shared(); }));
+	}
+
+	bool ProfiledSharedMutex::try_lock_shared()
+	{
+		if (!m_Mutex.try_lock_shared())
+			return false;
+
+		AddSharedHold(this, Instrumentor::IsCapturing() ? ProfilerClock::Now() : 0);
+		return true;
+	}
+
+	void ProfiledSharedMutex::unlock_shared()
+	{
+		const int64_t lockedAt = RemoveSharedHold(this);
+		m_Mutex.unlock_shared();
+		WriteHold(m_Site, lockedAt);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ProfileScope.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+namespace MyGame
+{
+	// One per profiled lock, see MYGAME_LOCK_SITE
+	struct ProfileLockSite
+	{
+		ProfileScope Wait;
+		ProfileScope Hold;
+		ProfileScope Contentions;
+		std::atomic<uint64_t> ContentionCount = 0;
+	};
+
+	// Drop-in std::mutex. While the Instrumentor captures, a contended lock records the wait as a
+	// "<lock> (wait)" scope and bumps the "<lock> (contentions)" counter track, and every unlock
+	// records the hold as "<lock> (hold)". Otherwise a lock costs a call and a flag check more.
+	class ProfiledMutex
+	{
+	public:
+		explicit ProfiledMutex(ProfileLockSite& site) : m_Site(site) {}
+
+		ProfiledMutex(const ProfiledMutex&) = delete;
+		ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+		void lock();
+		bool try_lock();
+		void unlock();
+
+	private:
+		std::mutex m_Mutex;
+		ProfileLockSite& m_Site;
+		int64_t m_LockedAt = 0; // Owner only, 0 if the lock was taken while nothing captured
+	};
+
+	// Drop-in std::shared_mutex, same records as ProfiledMutex for both exclusive and shared owners
+	class ProfiledSharedMutex
+	{
+	public:
+		explicit ProfiledSharedMutex(ProfileLockSite& site) : m_Site(site) {}
+
+		ProfiledSharedMutex(const ProfiledSharedMutex&) = delete;
+		ProfiledSharedMutex& operator=(const ProfiledSharedMutex&) = delete;
+
+		void lock();
+		bool try_lock();
+		void unlock();
+
+		void lock_shared();
+		bool try_lock_shared();
+		void unlock_shared();
+
+	private:
+		std::shared_mutex m_Mutex;
+		ProfileLockSite& m_Site;
+		int64_t m_LockedAt = 0;
+	};
+}
+
+// The site shared by every lock constructed from this expression, e.g. a class member initializer:
+//     ProfiledMutex m_Mutex{ MYGAME_LOCK_SITE("AssetCache::m_Mutex") };
+#define MYGAME_LOCK_SITE(name) []() -> ::MyGame::ProfileLockSite& { static constinit ::MyGame::ProfileLockSite site{ name " (wait)", name " (hold)", name " (contentions)" }; return site; }()
@@ -0,0 +1,87 @@
+#include "CommonHeaders.h"
+
+#include "ProfilerClock.h"
+
+#include <mutex>
+
+#if MYGAME_PROFILER_TSC && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+namespace MyGame
+{
+	namespace
+	{
+		// Only an invariant TSC ticks at a constant rate across P-states and C-states, and is
+		// synchronized between cores on any CPU that reports it (CPUID 0x80000007, EDX bit 8)
+		bool HasInvariantTSC()
+		{
+#if MYGAME_PROFILER_TSC
+#ifdef _MSC_VER
+			int registers[4] = {};
+			__cpuid(registers, 0x80000000);
+			if ((unsigned)registers[0] < 0x80000007)
+				return false;
+			__cpuid(registers, 0x80000007);
+			return (registers[3] & (1 << 8)) != 0;
+#else
+			unsigned int eax, ebx, ecx, edx;
+			if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+				return false;
+			return (edx & (1 << 8)) != 0;
+#endif
+#else
+			return false;
+#endif
+		}
+
+		int64_t SteadyNanoseconds() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+	}
+
+	void ProfilerClock::Calibrate()
+	{
+		s_UseTSC = HasInvariantTSC();
+		if (s_UseTSC)
+		{
+			// Ticks per nanosecond over a short spin. The steady_clock reads bracket the TSC reads,
+			// the error of a 20 ms window is well below what a single scope can resolve.
+			const int64_t startNanoseconds = SteadyNanoseconds();
+			const int64_t startTicks = Now();
+			int64_t endNanoseconds;
+			do
+			{
+				endNanoseconds = SteadyNanoseconds();
+			} while (endNanoseconds - startNanoseconds < 20'000'000);
+			const int64_t endTicks = Now();
+
+			s_NanosecondsPerTick = endTicks > startTicks ? (double)(endNanoseconds - startNanoseconds) / (endTicks - startTicks) : 1.0;
+			s_OriginTicks = startTicks;
+			s_OriginNanoseconds = startNanoseconds;
+			if (endTicks <= startTicks)
+				s_UseTSC = false;
+		}
+
+		if (!s_UseTSC)
+		{
+			s_NanosecondsPerTick = 1.0;
+			s_OriginTicks = 0;
+			s_OriginNanoseconds = 0;
+		}
+
+		// Cost of the two timestamps every scope takes: the fastest of many back-to-back reads,
+		// anything slower was interrupted
+		int64_t overhead = INT64_MAX;
+		for (int i = 0; i < 1000; i++)
+		{
+			const int64_t start = Now();
+			overhead = std::min(overhead, Now() - start);
+		}
+		s_OverheadTicks = std::max<int64_t>(overhead, 0);
+	}
+
+	void ProfilerClock::EnsureCalibrated()
+	{
+		static std::once_flag calibrated;
+		std::call_once(calibrated, Calibrate);
+	}
+}
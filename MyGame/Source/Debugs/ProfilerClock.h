@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MYGAME_PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MYGAME_PROFILER_TSC 1
+#else
+#define MYGAME_PROFILER_TSC 0
+#endif
+
+namespace MyGame
+{
+	// Timestamp source of the Instrumentor. Reads the invariant TSC when the CPU has one (a single
+	// instruction instead of a QueryPerformanceCounter / clock_gettime call) and steady_clock otherwise.
+	// Records keep raw ticks, they are only turned into nanoseconds when the writer serializes them.
+	class ProfilerClock
+	{
+	public:
+		// Picks the source, measures the tick rate against steady_clock and the cost of taking a
+		// timestamp. Spins for 20 ms, so it is left to EnsureCalibrated.
+		static void Calibrate();
+		// Calibrates on the first call only. The Instrumentor calls it when a session or capture
+		// begins, before anything records, so runs that never profile don't pay for it.
+		static void EnsureCalibrated();
+
+		static int64_t Now()
+		{
+#if MYGAME_PROFILER_TSC
+			if (s_UseTSC)
+				return (int64_t)__rdtsc();
+#endif
+			// Ticks of the fallback are nanoseconds, whatever the period of steady_clock
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// Timestamps convert onto the steady_clock time line, so they stay comparable with it
+		static int64_t ToNanoseconds(int64_t ticks) { return s_OriginNanoseconds + (int64_t)((ticks - s_OriginTicks) * s_NanosecondsPerTick); }
+
+		// Durations of scopes also drop what taking the two timestamps adds to them
+		static int64_t ToDuration(int64_t ticks) { return (int64_t)(std::max<int64_t>(ticks - s_OverheadTicks, 0) * s_NanosecondsPerTick); }
+		static int64_t ToFrameDuration(int64_t ticks) { return (int64_t)(ticks * s_NanosecondsPerTick); }
+
+		static bool IsUsingTSC() { return s_UseTSC; }
+		static double GetNanosecondsPerTick() { return s_NanosecondsPerTick; }
+		static int64_t GetOverheadTicks() { return s_OverheadTicks; }
+
+	private:
+		inline static bool s_UseTSC = false;
+		inline static double s_NanosecondsPerTick = 1.0;
+		inline static int64_t s_OriginTicks = 0;
+		inline static int64_t s_OriginNanoseconds = 0;
+		inline static int64_t s_OverheadTicks = 0;
+	};
+}
@@ -0,0 +1,284 @@
+#include "CommonHeaders.h"
+
+#include "SamplingProfiler.h"
+#include "ProfilerClock.h"
+#include "TraceFile.h"
+
+#include <DbgHelp.h>
+#include <Psapi.h>
+#include <sstream>
+
+#pragma comment(lib, "Dbghelp.lib")
+#pragma comment(lib, "Psapi.lib")
+
+namespace MyGame
+{
+	static_assert(SamplingProfiler::MaxDepth <= TraceFile::MaxSampleDepth, "Binary traces with deeper samples would fail to read");
+
+	// New modules are picked up within this, frames in them end the walk until then
+	static constexpr std::chrono::milliseconds s_ImageRefreshInterval(500);
+
+	static const SamplingProfiler::Image* FindImage(const std::vector<SamplingProfiler::Image>& images, uint64_t address)
+	{
+		auto it = std::upper_bound(images.begin(), images.end(), address, [](uint64_t value, const SamplingProfiler::Image& image) { return value < image.Base; });
+		if (it == images.begin() || address >= (--it)->End)
+			return nullptr;
+		return &*it;
+	}
+
+#if defined(_M_X64)
+	// RtlLookupFunctionEntry without the loader: a binary search of the image's exception directory
+	static PRUNTIME_FUNCTION FindFunctionEntry(const SamplingProfiler::Image& image, uint64_t address)
+	{
+		const DWORD rva = (DWORD)(address - image.Base);
+		auto* functions = reinterpret_cast<PRUNTIME_FUNCTION>(image.Base + image.FunctionTable);
+		auto* it = std::upper_bound(functions, functions + image.FunctionCount, rva, [](DWORD value, const RUNTIME_FUNCTION& function) { return value < function.BeginAddress; });
+		if (it == functions || rva >= (--it)->EndAddress)
+			return nullptr;
+
+		// An odd UnwindData points at the entry that holds the unwind data
+		if (it->UnwindData & 1)
+			return reinterpret_cast<PRUNTIME_FUNCTION>(image.Base + (it->UnwindData & ~1u));
+		return it;
+	}
+#endif
+
+	// Frame walk of a suspended thread. x64 code always has unwind data, except for leaf
+	// functions, which keep the return address on top of the stack. Nothing here may take a
+	// lock or touch memory the thread could have left unmapped: the walk stops at the first
+	// address outside a known image and never reads outside the live part of the stack.
+	static uint32_t WalkStack(CONTEXT& context, const std::vector<SamplingProfiler::Image>& images, uint64_t stackLow, uint64_t stackHigh, std::array<uint64_t, SamplingProfiler::MaxDepth>& frames)
+	{
+#if defined(_M_X64)
+		// Everything from the suspended Rsp up to the top of the stack is committed
+		if (context.Rsp < stackLow || context.Rsp >= stackHigh)
+			return 0;
+		stackLow = context.Rsp;
+
+		uint32_t depth = 0;
+		while (depth < SamplingProfiler::MaxDepth)
+		{
+			const SamplingProfiler::Image* image = FindImage(images, context.Rip);
+			if (!image)
+				break;
+			frames[depth++] = context.Rip;
+
+			const DWORD64 previousRsp = context.Rsp;
+			if (PRUNTIME_FUNCTION function = FindFunctionEntry(*image, context.Rip))
+			{
+				PVOID handlerData;
+				DWORD64 establisherFrame;
+				RtlVirtualUnwind(UNW_FLAG_NHANDLER, image->Base, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+			}
+			else
+			{
+				if (context.Rsp + sizeof(DWORD64) > stackHigh)
+					break;
+				context.Rip = *reinterpret_cast<const DWORD64*>(context.Rsp);
+				context.Rsp += sizeof(DWORD64);
+			}
+
+			// Unwinding only ever moves up the stack, anything else is a corrupt frame
+			if (context.Rsp <= previousRsp || context.Rsp < stackLow || context.Rsp >= stackHigh)
+				break;
+		}
+		return depth;
+#else
+		// No unwind tables to walk, the current function is all we get
+		if (!FindImage(images, context.Eip))
+			return 0;
+		frames[0] = context.Eip;
+		return 1;
+#endif
+	}
+
+	SamplingProfiler::~SamplingProfiler()
+	{
+		Stop();
+
+		for (SampledThread& thread : m_Threads)
+			CloseHandle(thread.Handle);
+		if (m_SymbolsInitialized)
+			SymCleanup(GetCurrentProcess());
+	}
+
+	void SamplingProfiler::AddThread(uint64_t threadID, uint32_t threadIndex)
+	{
+		// std::thread::id is the Win32 thread ID
+		HANDLE handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, (DWORD)threadID);
+		if (!handle)
+			return;
+
+		// Only the thread itself can ask for its stack range
+		ULONG_PTR stackLow, stackHigh;
+		GetCurrentThreadStackLimits(&stackLow, &stackHigh);
+
+		std::lock_guard lock(m_ThreadsMutex);
+		m_Threads.push_back({ handle, threadID, threadIndex, stackLow, stackHigh });
+	}
+
+	void SamplingProfiler::Start(std::chrono::microseconds interval)
+	{
+		if (m_Sampler.joinable())
+			return;
+
+		{
+			std::lock_guard lock(m_SamplesMutex);
+			m_Samples.clear();
+			m_Samples.reserve(Capacity);
+		}
+
+		m_SamplerRunning = true;
+		m_Sampler = std::thread(&SamplingProfiler::SamplerThread, this, interval);
+	}
+
+	void SamplingProfiler::Stop()
+	{
+		if (!m_Sampler.joinable())
+			return;
+
+		m_SamplerRunning = false;
+		m_Sampler.join();
+	}
+
+	void SamplingProfiler::SamplerThread(std::chrono::microseconds interval)
+	{
+		// The default timer resolution (15.6 ms) would turn any interval into 16 ms
+		HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!timer)
+			timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+		const DWORD samplerThreadID = GetCurrentThreadId();
+		auto lastImageRefresh = std::chrono::steady_clock::now();
+		RefreshImages();
+		while (m_SamplerRunning.load(std::memory_order_relaxed))
+		{
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -(LONGLONG)interval.count() * 10; // Relative, in 100 ns units
+			if (timer && SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+				WaitForSingleObject(timer, INFINITE);
+			else
+				std::this_thread::sleep_for(interval);
+
+			if (std::chrono::steady_clock::now() - lastImageRefresh >= s_ImageRefreshInterval)
+			{
+				RefreshImages();
+				lastImageRefresh = std::chrono::steady_clock::now();
+			}
+
+			std::lock_guard threadsLock(m_ThreadsMutex);
+			for (const SampledThread& thread : m_Threads)
+			{
+				if (thread.ThreadID == samplerThreadID || WaitForSingleObject(thread.Handle, 0) == WAIT_OBJECT_0)
+					continue;
+
+				// Nothing between Suspend and Resume may allocate or take a lock the target could hold
+				Sample sample;
+				sample.ThreadID = thread.ThreadID;
+				sample.ThreadIndex = thread.ThreadIndex;
+				sample.Depth = 0;
+				if (SuspendThread(thread.Handle) == (DWORD)-1)
+					continue;
+
+				sample.Timestamp = ProfilerClock::Now();
+				CONTEXT context = {};
+				context.ContextFlags = CONTEXT_FULL;
+				if (GetThreadContext(thread.Handle, &context))
+					sample.Depth = WalkStack(context, m_Images, thread.StackLow, thread.StackHigh, sample.Frames);
+				ResumeThread(thread.Handle);
+
+				if (!sample.Depth)
+					continue;
+
+				std::lock_guard samplesLock(m_SamplesMutex);
+				if (m_Samples.size() < Capacity)
+					m_Samples.push_back(sample);
+				else
+					m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (timer)
+			CloseHandle(timer);
+		ReleaseImages();
+	}
+
+	void SamplingProfiler::RefreshImages()
+	{
+		// Takes the loader lock, so only between samples while no thread is suspended
+		std::vector<HMODULE> modules(256);
+		DWORD needed = 0;
+		for (;;)
+		{
+			const DWORD size = (DWORD)(modules.size() * sizeof(HMODULE));
+			if (!EnumProcessModules(GetCurrentProcess(), modules.data(), size, &needed))
+				return; // Keeps the previous table
+			if (needed <= size)
+				break;
+			modules.resize(needed / sizeof(HMODULE));
+		}
+		modules.resize(needed / sizeof(HMODULE));
+
+		std::vector<Image> images;
+		images.reserve(modules.size());
+		for (HMODULE module : modules)
+		{
+			HMODULE handle;
+			if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(module), &handle))
+				continue;
+
+			const uint64_t base = reinterpret_cast<uint64_t>(handle);
+			const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+			const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dosHeader->e_lfanew);
+			const IMAGE_DATA_DIRECTORY& exceptions = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+			images.push_back({ base, base + ntHeaders->OptionalHeader.SizeOfImage, exceptions.VirtualAddress, exceptions.Size / (uint32_t)sizeof(IMAGE_RUNTIME_FUNCTION_ENTRY), handle });
+		}
+		std::sort(images.begin(), images.end(), [](const Image& a, const Image& b) { return a.Base < b.Base; });
+
+		ReleaseImages();
+		m_Images = std::move(images);
+	}
+
+	void SamplingProfiler::ReleaseImages()
+	{
+		for (Image& image : m_Images)
+			FreeLibrary(static_cast<HMODULE>(image.Handle));
+		m_Images.clear();
+	}
+
+	const SamplingProfiler::Symbol& SamplingProfiler::GetSymbol(uint64_t address)
+	{
+		auto it = m_Symbols.find(address);
+		if (it != m_Symbols.end())
+			return it->second;
+
+		if (!m_SymbolsInitialized)
+		{
+			SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+			SymInitialize(GetCurrentProcess(), nullptr, TRUE);
+			m_SymbolsInitialized = true;
+		}
+
+		alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+		SYMBOL_INFO* info = reinterpret_cast<SYMBOL_INFO*>(buffer);
+		info->SizeOfStruct = sizeof(SYMBOL_INFO);
+		info->MaxNameLen = MAX_SYM_NAME;
+
+		std::string name;
+		DWORD64 displacement;
+		if (SymFromAddr(GetCurrentProcess(), address, &displacement, info))
+		{
+			name.assign(info->Name, info->NameLen);
+		}
+		else
+		{
+			std::stringstream stream;
+			stream << "0x" << std::hex << address;
+			name = stream.str();
+		}
+
+		const uint32_t nameID = TraceFile::HashName(name);
+		return m_Symbols.emplace(address, Symbol{ std::move(name), nameID }).first->second;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MyGame
+{
+	// Statistical profiler for the code nobody annotated: vendor libraries and engine code without
+	// MYGAME_PROFILE_SCOPEs. While a trace session runs with sampling enabled, a sampler thread
+	// periodically suspends every thread the Instrumentor knows about, walks its stack and resumes it.
+	// The Instrumentor's writer symbolizes the samples and interleaves them with the scopes.
+	class SamplingProfiler
+	{
+	public:
+		static constexpr uint32_t MaxDepth = 32;
+		static constexpr size_t Capacity = 4096;
+		// Shorter intervals spend more time suspending threads than running them
+		static constexpr std::chrono::microseconds MinInterval{ 100 };
+
+		struct Sample
+		{
+			uint64_t ThreadID;
+			uint32_t ThreadIndex;
+			uint32_t Depth;
+			int64_t Timestamp; // ProfilerClock ticks
+			std::array<uint64_t, MaxDepth> Frames; // Return addresses, innermost first
+		};
+
+		struct Symbol
+		{
+			std::string Name;
+			uint32_t NameID;
+		};
+
+		// A loaded image and its unwind data. The table is built before any thread is suspended, so
+		// the walk never calls into the loader, whose lock a suspended thread may hold.
+		struct Image
+		{
+			uint64_t Base;
+			uint64_t End;
+			uint32_t FunctionTable; // RVA of the exception directory's RUNTIME_FUNCTIONs, sorted by address
+			uint32_t FunctionCount;
+			void* Handle;           // A reference of our own, the image can't unload while it is in the table
+		};
+
+		SamplingProfiler() = default;
+		~SamplingProfiler();
+
+		SamplingProfiler(const SamplingProfiler&) = delete;
+		SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+		// Called by every thread that records profiling data, sampled or not, on that thread
+		void AddThread(uint64_t threadID, uint32_t threadIndex);
+
+		// Both are no-ops if already in that state
+		void Start(std::chrono::microseconds interval);
+		void Stop();
+		bool IsRunning() const { return m_Sampler.joinable(); }
+
+		// Drain and GetSymbol must not run concurrently, the Instrumentor calls them under its m_Mutex
+		template<typename F>
+		void Drain(F&& func)
+		{
+			{
+				std::lock_guard lock(m_SamplesMutex);
+				std::swap(m_Samples, m_Draining);
+				m_Samples.reserve(Capacity);
+			}
+			for (const Sample& sample : m_Draining)
+				func(sample);
+			m_Draining.clear();
+		}
+
+		// Names are cached per address
+		const Symbol& GetSymbol(uint64_t address);
+
+		uint64_t TakeDropped() { return m_Dropped.exchange(0, std::memory_order_relaxed); }
+
+	private:
+		void SamplerThread(std::chrono::microseconds interval);
+		void RefreshImages();
+		void ReleaseImages();
+
+	private:
+		struct SampledThread
+		{
+			void* Handle;
+			uint64_t ThreadID;
+			uint32_t ThreadIndex;
+			uint64_t StackLow;  // Reserved range of the thread's stack, the walk never reads outside of it
+			uint64_t StackHigh;
+		};
+		std::vector<SampledThread> m_Threads;
+		std::mutex m_ThreadsMutex;
+
+		// Reserved by Start and Drain, the sampler must not allocate: a thread it suspended may hold the heap lock
+		std::vector<Sample> m_Samples;
+		std::vector<Sample> m_Draining;
+		std::mutex m_SamplesMutex;
+		std::atomic<uint64_t> m_Dropped = 0;
+
+		std::thread m_Sampler;
+		std::atomic<bool> m_SamplerRunning = false;
+		std::vector<Image> m_Images; // Sampler thread only, sorted by Base
+
+		std::unordered_map<uint64_t, Symbol> m_Symbols;
+		bool m_SymbolsInitialized = false;
+	};
+}
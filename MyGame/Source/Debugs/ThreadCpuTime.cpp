@@ -0,0 +1,35 @@
+#include "CommonHeaders.h"
+
+#include "ThreadCpuTime.h"
+#include "ProfilerClock.h"
+
+namespace MyGame
+{
+	void* ThreadCpuTime::Open(uint64_t threadID)
+	{
+		// std::thread::id is the Win32 thread ID
+		return OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)threadID);
+	}
+
+	void ThreadCpuTime::Close(void* handle)
+	{
+		if (handle)
+			CloseHandle(handle);
+	}
+
+	int64_t ThreadCpuTime::Get(void* handle)
+	{
+		// The thread cycle time counts at the invariant TSC rate, the ProfilerClock's calibration converts it.
+		// Without a TSC fall back to the scheduler's times, which only advance once per clock interrupt.
+		ULONG64 cycles;
+		if (ProfilerClock::IsUsingTSC() && QueryThreadCycleTime(handle, &cycles))
+			return ProfilerClock::ToFrameDuration((int64_t)cycles);
+
+		FILETIME creation, exit, kernel, user;
+		if (!GetThreadTimes(handle, &creation, &exit, &kernel, &user))
+			return 0;
+
+		auto toNanoseconds = [](const FILETIME& time) { return (((int64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) * 100; };
+		return toNanoseconds(kernel) + toNanoseconds(user);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MyGame
+{
+	// Time a thread actually ran on a core, as opposed to the wall time spent in its scopes.
+	// Any thread can query any other thread through the handle.
+	class ThreadCpuTime
+	{
+	public:
+		// nullptr if the thread can't be opened
+		static void* Open(uint64_t threadID);
+		static void Close(void* handle);
+
+		// Nanoseconds the thread has run so far
+		static int64_t Get(void* handle);
+	};
+}
@@ -0,0 +1,480 @@
+#pragma once
+
+// Shared by the engine and the offline tools, so this header must not
+// depend on anything but the standard library.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace MyGame::TraceFile
+{
+	// Binary session layout:
+	//   FileHeader, session name
+	//   { RecordType, record [, payload] }*
+	// Names and threads are emitted once, the first time a record references them.
+	// A NameID is HashName of the name, so IDs match between sessions and builds.
+
+	constexpr char Magic[8] = { 'M', 'G', 'T', 'R', 'A', 'C', 'E', '\0' };
+	// Bump whenever a record is added or changes, older readers stop at the header instead of an unknown record
+	constexpr uint32_t Version = 3;
+	constexpr std::string_view BinaryExtension = ".mgtrace";
+
+	// Limits Read holds records to, anything larger is a corrupt file rather than a long name or stack
+	constexpr uint32_t MaxNameLength = 64 * 1024;
+	constexpr uint32_t MaxSampleDepth = 32;
+
+	enum class RecordType : uint8_t
+	{
+		None = 0,
+		Name, Thread, Scope, Frame, Counter, Allocation, Flow, Sample, ThreadName
+	};
+
+	enum class AllocationKind : uint8_t
+	{
+		Scope, Tag
+	};
+
+	enum class FlowPhase : uint8_t
+	{
+		Begin, End
+	};
+
+#pragma pack(push, 1)
+	struct FileHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t SessionNameLength;
+	};
+
+	// Followed by Length bytes of the name, not null terminated
+	struct NameRecord
+	{
+		uint32_t NameID;
+		uint32_t Length;
+	};
+
+	struct ThreadRecord
+	{
+		uint32_t ThreadIndex;
+		uint64_t ThreadID;
+	};
+
+	// Written when the session ends, for threads named with MYGAME_PROFILE_THREAD
+	struct ThreadNameRecord
+	{
+		uint32_t ThreadIndex;
+		uint32_t NameID;
+	};
+
+	// Timestamps are nanoseconds
+	struct ScopeRecord
+	{
+		uint32_t NameID;
+		uint32_t ThreadIndex;
+		int64_t Start;
+		int64_t Duration;
+	};
+
+	// Written by the thread calling MYGAME_PROFILE_FRAME_MARK, covers a whole frame
+	struct FrameRecord
+	{
+		uint32_t ThreadIndex;
+		int64_t Start;
+		int64_t Duration;
+	};
+
+	// One sample of the counter track called NameID
+	struct CounterRecord
+	{
+		uint32_t NameID;
+		uint32_t ThreadIndex;
+		int64_t Timestamp;
+		double Value;
+	};
+
+	// One end of a flow arrow between threads. Both ends share the FlowID and bind to the
+	// scope enclosing their timestamp on their thread.
+	struct FlowRecord
+	{
+		uint32_t NameID;
+		uint32_t ThreadIndex;
+		int64_t Timestamp;
+		uint64_t FlowID;
+		FlowPhase Phase;
+	};
+
+	// Call stack of a thread taken by the sampling profiler, followed by Depth
+	// NameIDs of the functions on it, innermost first
+	struct SampleRecord
+	{
+		uint32_t ThreadIndex;
+		int64_t Timestamp;
+		uint32_t Depth;
+	};
+
+	// Heap totals of one scope or tag, written when the session ends (MYGAME_TRACK_ALLOCATIONS builds)
+	struct AllocationRecord
+	{
+		uint32_t NameID;
+		AllocationKind Kind;
+		uint64_t Count;
+		uint64_t Bytes;
+		int64_t LiveBytes;
+		int64_t PeakBytes;
+	};
+#pragma pack(pop)
+
+	// 32 bit FNV-1a, never 0 so that can mean "no name"
+	constexpr uint32_t HashName(std::string_view name)
+	{
+		uint32_t hash = 2166136261u;
+		for (char c : name)
+			hash = (hash ^ (uint8_t)c) * 16777619u;
+		return hash ? hash : 1;
+	}
+
+	inline bool IsBinaryPath(std::string_view filepath)
+	{
+		return filepath.size() >= BinaryExtension.size() && filepath.substr(filepath.size() - BinaryExtension.size()) == BinaryExtension;
+	}
+
+	template<typename T>
+	void Write(std::ostream& stream, RecordType type, const T& record)
+	{
+		stream.put((char)type);
+		stream.write(reinterpret_cast<const char*>(&record), sizeof(T));
+	}
+
+	inline void WriteBinaryHeader(std::ostream& stream, const std::string& sessionName)
+	{
+		FileHeader header = {};
+		std::memcpy(header.Magic, Magic, sizeof(Magic));
+		header.Version = Version;
+		header.SessionNameLength = (uint32_t)sessionName.size();
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(sessionName.data(), sessionName.size());
+	}
+
+	inline void WriteName(std::ostream& stream, uint32_t nameID, std::string_view name)
+	{
+		Write(stream, RecordType::Name, NameRecord{ nameID, (uint32_t)name.size() });
+		stream.write(name.data(), name.size());
+	}
+
+	// Quoted JSON string. Names come from function signatures, DbgHelp symbols, allocation tags and
+	// thread names, so quotes, backslashes and control characters are all escaped.
+	inline void WriteJsonString(std::ostream& stream, std::string_view text)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+
+		stream << '"';
+		for (char c : text)
+		{
+			switch (c)
+			{
+			case '"': stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n"; break;
+			case '\r': stream << "\\r"; break;
+			case '\t': stream << "\\t"; break;
+			case '\b': stream << "\\b"; break;
+			case '\f': stream << "\\f"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+					stream << "\\u00" << hex[(unsigned char)c >> 4] << hex[c & 0xf];
+				else
+					stream << c;
+				break;
+			}
+		}
+		stream << '"';
+	}
+
+	// Quoted CSV field (RFC 4180), embedded quotes are doubled
+	inline void WriteCsvString(std::ostream& stream, std::string_view text)
+	{
+		stream << '"';
+		for (char c : text)
+		{
+			if (c == '"')
+				stream << '"';
+			stream << c;
+		}
+		stream << '"';
+	}
+
+	// Chrome / Perfetto JSON, used for live .json sessions and by the converter
+	inline void WriteChromeHeader(std::ostream& stream)
+	{
+		stream << "{\"otherData\": {},\"traceEvents\":[{}";
+	}
+
+	inline void WriteChromeScope(std::ostream& stream, std::string_view name, uint64_t threadID, int64_t start, int64_t duration)
+	{
+		stream << std::setprecision(3) << std::fixed;
+		stream << ",{";
+		stream << "\"cat\":\"function\",";
+		stream << "\"dur\":" << (duration / 1000.0) << ',';
+		stream << "\"name\":";
+		WriteJsonString(stream, name);
+		stream << ',';
+		stream << "\"ph\":\"X\",";
+		stream << "\"pid\":0,";
+		stream << "\"tid\":" << threadID << ",";
+		stream << "\"ts\":" << (start / 1000.0);
+		stream << "}";
+	}
+
+	inline void WriteChromeCounter(std::ostream& stream, std::string_view name, uint64_t threadID, int64_t timestamp, double value)
+	{
+		stream << std::setprecision(3) << std::fixed;
+		stream << ",{";
+		stream << "\"args\":{\"value\":" << value << "},";
+		stream << "\"name\":";
+		WriteJsonString(stream, name);
+		stream << ',';
+		stream << "\"ph\":\"C\",";
+		stream << "\"pid\":0,";
+		stream << "\"tid\":" << threadID << ",";
+		stream << "\"ts\":" << (timestamp / 1000.0);
+		stream << "}";
+	}
+
+	// Flow events ("ph":"s" / "f"), the end binds to the enclosing slice instead of the next one
+	inline void WriteChromeFlow(std::ostream& stream, std::string_view name, FlowPhase phase, uint64_t threadID, int64_t timestamp, uint64_t flowID)
+	{
+		stream << std::setprecision(3) << std::fixed;
+		stream << ",{";
+		stream << "\"cat\":\"flow\",";
+		stream << "\"id\":" << flowID << ',';
+		stream << "\"name\":";
+		WriteJsonString(stream, name);
+		stream << ',';
+		stream << (phase == FlowPhase::Begin ? "\"ph\":\"s\"," : "\"ph\":\"f\",\"bp\":\"e\",");
+		stream << "\"pid\":0,";
+		stream << "\"tid\":" << threadID << ",";
+		stream << "\"ts\":" << (timestamp / 1000.0);
+		stream << "}";
+	}
+
+	// Thread instant event named after the sampled function, the stack is an argument with the
+	// outermost function first
+	inline void WriteChromeSample(std::ostream& stream, std::string_view name, uint64_t threadID, int64_t timestamp, std::string_view stack)
+	{
+		stream << std::setprecision(3) << std::fixed;
+		stream << ",{";
+		stream << "\"args\":{\"stack\":";
+		WriteJsonString(stream, stack);
+		stream << "},";
+		stream << "\"cat\":\"sample\",";
+		stream << "\"name\":";
+		WriteJsonString(stream, name);
+		stream << ',';
+		stream << "\"ph\":\"i\",";
+		stream << "\"s\":\"t\",";
+		stream << "\"pid\":0,";
+		stream << "\"tid\":" << threadID << ",";
+		stream << "\"ts\":" << (timestamp / 1000.0);
+		stream << "}";
+	}
+
+	// Global instant event, the totals show up as its arguments
+	inline void WriteChromeAllocation(std::ostream& stream, std::string_view name, AllocationKind kind, int64_t timestamp, uint64_t count, uint64_t bytes, int64_t liveBytes, int64_t peakBytes)
+	{
+		stream << std::setprecision(3) << std::fixed;
+		stream << ",{";
+		stream << "\"args\":{\"allocations\":" << count << ",\"bytes\":" << bytes << ",\"live_bytes\":" << liveBytes << ",\"peak_bytes\":" << peakBytes << "},";
+		stream << "\"cat\":\"" << (kind == AllocationKind::Tag ? "allocation_tag" : "allocation") << "\",";
+		stream << "\"name\":";
+		WriteJsonString(stream, name);
+		stream << ',';
+		stream << "\"ph\":\"i\",";
+		stream << "\"s\":\"g\",";
+		stream << "\"pid\":0,";
+		stream << "\"tid\":0,";
+		stream << "\"ts\":" << (timestamp / 1000.0);
+		stream << "}";
+	}
+
+	// Metadata event, viewers label the thread's track with it
+	inline void WriteChromeThreadName(std::ostream& stream, uint64_t threadID, std::string_view name)
+	{
+		stream << ",{";
+		stream << "\"args\":{\"name\":";
+		WriteJsonString(stream, name);
+		stream << "},";
+		stream << "\"name\":\"thread_name\",";
+		stream << "\"ph\":\"M\",";
+		stream << "\"pid\":0,";
+		stream << "\"tid\":" << threadID;
+		stream << "}";
+	}
+
+	inline void WriteChromeFooter(std::ostream& stream)
+	{
+		stream << "]}";
+	}
+
+	struct Sample
+	{
+		uint32_t ThreadIndex;
+		int64_t Timestamp;
+		std::vector<uint32_t> Frames; // NameIDs, innermost first
+	};
+
+	struct Trace
+	{
+		std::string SessionName;
+		std::unordered_map<uint32_t, std::string> Names;
+		std::unordered_map<uint32_t, uint64_t> Threads;
+		std::unordered_map<uint32_t, uint32_t> ThreadNames; // Thread index -> NameID
+		std::vector<ScopeRecord> Scopes;
+		std::vector<FrameRecord> Frames;
+		std::vector<CounterRecord> Counters;
+		std::vector<AllocationRecord> Allocations;
+		std::vector<FlowRecord> Flows;
+		std::vector<Sample> Samples;
+
+		const std::string& GetName(uint32_t nameID) const
+		{
+			static const std::string unknown = "<unknown>";
+			auto it = Names.find(nameID);
+			return it != Names.end() ? it->second : unknown;
+		}
+
+		uint64_t GetThreadID(uint32_t threadIndex) const
+		{
+			auto it = Threads.find(threadIndex);
+			return it != Threads.end() ? it->second : threadIndex;
+		}
+	};
+
+	// Returns false if the file is missing, not a binary session or has a record over the limits
+	// above. A truncated file (e.g. the game crashed mid capture) keeps everything read until then.
+	inline bool Read(const std::string& filepath, Trace& trace)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+			return false;
+
+		FileHeader header = {};
+		if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0 || header.Version != Version)
+			return false;
+
+		if (header.SessionNameLength > MaxNameLength)
+			return false;
+		trace.SessionName.resize(header.SessionNameLength);
+		stream.read(trace.SessionName.data(), header.SessionNameLength);
+
+		char type;
+		while (stream.get(type))
+		{
+			switch ((RecordType)type)
+			{
+			case RecordType::Name:
+			{
+				NameRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+				if (record.Length > MaxNameLength)
+					return false;
+
+				std::string& name = trace.Names[record.NameID];
+				name.resize(record.Length);
+				stream.read(name.data(), record.Length);
+				break;
+			}
+			case RecordType::Thread:
+			{
+				ThreadRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Threads[record.ThreadIndex] = record.ThreadID;
+				break;
+			}
+			case RecordType::ThreadName:
+			{
+				ThreadNameRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.ThreadNames[record.ThreadIndex] = record.NameID;
+				break;
+			}
+			case RecordType::Scope:
+			{
+				ScopeRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Scopes.push_back(record);
+				break;
+			}
+			case RecordType::Frame:
+			{
+				FrameRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Frames.push_back(record);
+				break;
+			}
+			case RecordType::Counter:
+			{
+				CounterRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Counters.push_back(record);
+				break;
+			}
+			case RecordType::Allocation:
+			{
+				AllocationRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Allocations.push_back(record);
+				break;
+			}
+			case RecordType::Flow:
+			{
+				FlowRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+
+				trace.Flows.push_back(record);
+				break;
+			}
+			case RecordType::Sample:
+			{
+				SampleRecord record;
+				if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return true;
+				if (record.Depth > MaxSampleDepth)
+					return false;
+
+				Sample sample = { record.ThreadIndex, record.Timestamp, std::vector<uint32_t>(record.Depth) };
+				if (!stream.read(reinterpret_cast<char*>(sample.Frames.data()), record.Depth * sizeof(uint32_t)))
+					return true;
+
+				trace.Samples.push_back(std::move(sample));
+				break;
+			}
+			default:
+				// Unknown record, the rest of the file can't be interpreted
+				return true;
+			}
+		}
+		return true;
+	}
+}
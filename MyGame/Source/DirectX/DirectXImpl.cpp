@@ -3,6 +3,7 @@
 #include "DirectXImpl.h"
 #include "../Core/Application.h"
 #include "../Debugs/DebugHelpers.h"
+#include "../Debugs/InputLatency.h"
 
 // ImGui
 #include <backends/imgui_impl_dx12.h>
@@ -105,6 +106,7 @@ namespace MyGame
 			m_swapChain->Present(1, 0); // VSync On
 		else
 			m_swapChain->Present(0, 0); // VSync Off
+		InputLatency::OnPresent();
 
 		UINT64 fenceValue = m_fenceValue + 1;
 		m_commandQueue->Signal(m_fence.Get(), fenceValue);
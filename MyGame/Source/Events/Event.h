@@ -12,6 +12,8 @@ namespace MyGame
 		MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled
 	};
 
+	inline constexpr int EventTypeCount = (int)EventType::MouseScrolled + 1;
+
 	enum EventCategory
 	{
 		None = 0,
@@ -0,0 +1,64 @@
+#include "CommonHeaders.h"
+
+#include "EventChannel.h"
+
+namespace MyGame
+{
+	// A cell whose sequence equals a position is free for the producer claiming that position,
+	// position + 1 means published for the consumer, and the consumer frees it for the next lap.
+	EventChannel::EventChannel()
+	{
+		for (size_t i = 0; i < Capacity; i++)
+			m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool EventChannel::Post(const EventValue& event)
+	{
+		size_t position = m_Head.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_Cells[position & (Capacity - 1)];
+			const intptr_t difference = (intptr_t)cell.Sequence.load(std::memory_order_acquire) - (intptr_t)position;
+			if (difference == 0)
+			{
+				if (m_Head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.Event = event;
+					MYGAME_PROFILE_FLOW_BEGIN(cell.Flow, "Posted event");
+					cell.Sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer hasn't freed the cell from the previous lap yet
+				m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				// Another producer claimed the position first
+				position = m_Head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	size_t EventChannel::Drain(const std::function<void(const EventValue&)>& func)
+	{
+		size_t count = 0;
+		for (; count < Capacity; count++)
+		{
+			Cell& cell = m_Cells[m_Tail & (Capacity - 1)];
+			if (cell.Sequence.load(std::memory_order_acquire) != m_Tail + 1)
+				break;
+
+			const EventValue event = cell.Event;
+			MYGAME_PROFILE_FLOW_END(cell.Flow, "Posted event");
+			cell.Sequence.store(m_Tail + Capacity, std::memory_order_release);
+			m_Tail++;
+
+			func(event);
+		}
+		return count;
+	}
+}
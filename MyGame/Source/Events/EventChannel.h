@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../Events/EventValue.h"
+#include "../Debugs/Instrumentor.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+
+namespace MyGame
+{
+	// Multiple producer (any thread), single consumer (main thread) bounded ring of events.
+	// Producers claim a cell with one compare exchange on the head and publish it through the
+	// cell's sequence number, so posting never takes a lock and never allocates.
+	class EventChannel
+	{
+	public:
+		static constexpr size_t Capacity = 1 << 10;
+
+		EventChannel();
+
+		EventChannel(const EventChannel&) = delete;
+		EventChannel& operator=(const EventChannel&) = delete;
+
+		// Any thread. False when the channel is full, the event is dropped and counted.
+		bool Post(const EventValue& event);
+
+		// Consumer side only. Hands over the events published so far in the order they were
+		// claimed, at most Capacity per call so busy producers can't keep the consumer looping.
+		size_t Drain(const std::function<void(const EventValue&)>& func);
+
+		uint64_t TakeDropped() { return m_Dropped.exchange(0, std::memory_order_relaxed); }
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> Sequence;
+			EventValue Event;
+			ProfileFlow Flow;
+		};
+
+		std::array<Cell, Capacity> m_Cells;
+
+		alignas(64) std::atomic<size_t> m_Head = 0;
+		alignas(64) size_t m_Tail = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+	};
+}
@@ -0,0 +1,80 @@
+#include "CommonHeaders.h"
+
+#include "EventQueue.h"
+
+namespace MyGame
+{
+	void EventQueue::Push(const EventValue& event)
+	{
+		if (event.Type == EventType::MouseMoved && m_RecordMouseSamples)
+			m_MouseSamples.push_back({ event.Cursor.X, event.Cursor.Y });
+
+		if (m_Coalescing && Coalesce(event))
+		{
+			m_CoalescedCount++;
+			return;
+		}
+
+		if (event.Type == EventType::WindowResize)
+			m_ResizeIndex = m_Events.size();
+		m_Events.push_back(event);
+	}
+
+	void EventQueue::Dispatch(const std::function<void(Event&)>& callback)
+	{
+		// Indexed and copied on purpose, handlers may push more events while the batch runs
+		while (m_DispatchIndex < m_Events.size())
+		{
+			const EventValue event = m_Events[m_DispatchIndex++];
+			DispatchEventValue(event, callback);
+		}
+
+		Clear();
+	}
+
+	bool EventQueue::Coalesce(const EventValue& event)
+	{
+		switch (event.Type)
+		{
+		case EventType::MouseMoved:
+		{
+			if (m_Events.size() <= m_DispatchIndex || m_Events.back().Type != EventType::MouseMoved)
+				return false;
+
+			m_Events.back().Cursor = event.Cursor;
+			return true;
+		}
+		case EventType::MouseScrolled:
+		{
+			if (m_Events.size() <= m_DispatchIndex || m_Events.back().Type != EventType::MouseScrolled)
+				return false;
+
+			m_Events.back().Scroll.XOffset += event.Scroll.XOffset;
+			m_Events.back().Scroll.YOffset += event.Scroll.YOffset;
+			return true;
+		}
+		case EventType::WindowResize:
+		{
+			// Resizes don't need to be consecutive, every one of them would recreate the render targets
+			if (m_ResizeIndex == SIZE_MAX || m_ResizeIndex < m_DispatchIndex)
+				return false;
+
+			m_Events[m_ResizeIndex].Size = event.Size;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	void EventQueue::Clear()
+	{
+		// The capacity stays for the next frame
+		m_Events.clear();
+		m_DispatchIndex = 0;
+		m_ResizeIndex = SIZE_MAX;
+
+		m_CoalescedCount = 0;
+		m_MouseSamples.clear();
+	}
+}
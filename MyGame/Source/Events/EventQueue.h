@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../Events/Event.h"
+#include "../Events/EventValue.h"
+
+#include <functional>
+#include <vector>
+
+namespace MyGame
+{
+	// Events collected during a frame and dispatched together at one point of the frame.
+	// They are stored as EventValues in one contiguous buffer whose capacity is kept from frame
+	// to frame, so queueing an event is a copy of 16 bytes and never touches the heap once warm.
+	//
+	// High frequency events are coalesced while queued: consecutive mouse moves keep the last
+	// position, consecutive scrolls add up and all resizes of the frame become the last size.
+	class EventQueue
+	{
+	public:
+		struct MouseSample
+		{
+			float X, Y;
+		};
+
+		void Push(const EventValue& event);
+
+		// Events pushed by the handlers are dispatched in the same batch, the queue is empty afterwards
+		void Dispatch(const std::function<void(Event&)>& callback);
+
+		size_t GetSize() const { return m_Events.size(); }
+		bool IsEmpty() const { return m_Events.empty(); }
+
+		// Off queues every event as it arrived
+		void SetCoalescing(bool enabled) { m_Coalescing = enabled; }
+		bool IsCoalescing() const { return m_Coalescing; }
+		// Events merged into queued ones since the last dispatch
+		uint32_t GetCoalescedCount() const { return m_CoalescedCount; }
+
+		// Every cursor position of the frame, for handlers that need more than the coalesced move
+		// (strokes, gestures). Only filled while enabled, valid until the end of the dispatch.
+		void SetRecordMouseSamples(bool enabled) { m_RecordMouseSamples = enabled; }
+		const std::vector<MouseSample>& GetMouseSamples() const { return m_MouseSamples; }
+
+	private:
+		// True when the event was merged into one that isn't dispatched yet
+		bool Coalesce(const EventValue& event);
+		void Clear();
+
+	private:
+		std::vector<EventValue> m_Events; // In the order they were pushed
+		size_t m_DispatchIndex = 0; // Events before it are dispatched and can't take merges anymore
+		size_t m_ResizeIndex = SIZE_MAX;
+
+		bool m_Coalescing = true;
+		uint32_t m_CoalescedCount = 0;
+
+		bool m_RecordMouseSamples = false;
+		std::vector<MouseSample> m_MouseSamples;
+	};
+}
@@ -0,0 +1,96 @@
+#include "CommonHeaders.h"
+
+#include "EventRecording.h"
+#include "../Core/Log.h"
+
+namespace MyGame
+{
+	bool EventRecorder::Open(const std::string& filepath)
+	{
+		m_Stream.open(filepath, std::ios::binary | std::ios::trunc);
+		if (!m_Stream)
+			return false;
+
+		EventRecording::FileHeader header = {};
+		std::memcpy(header.Magic, EventRecording::Magic, sizeof(header.Magic));
+		header.Version = EventRecording::Version;
+		m_Stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		m_Start = std::chrono::steady_clock::now();
+		m_Frame = 0;
+		m_Events.clear();
+		return true;
+	}
+
+	void EventRecorder::Close()
+	{
+		m_Stream.close();
+	}
+
+	void EventRecorder::Record(const EventValue& event)
+	{
+		if (IsOpen())
+			m_Events.push_back({ GetTimestamp(), event });
+	}
+
+	void EventRecorder::EndFrame(float timestep)
+	{
+		if (!IsOpen())
+			return;
+
+		const EventRecording::FrameRecord frame = { m_Frame++, GetTimestamp(), timestep, (uint32_t)m_Events.size() };
+		m_Stream.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+		m_Stream.write(reinterpret_cast<const char*>(m_Events.data()), m_Events.size() * sizeof(EventRecording::EventRecord));
+		m_Events.clear();
+	}
+
+	bool EventReplay::Open(const std::string& filepath)
+	{
+		m_Stream.open(filepath, std::ios::binary | std::ios::ate);
+		if (!m_Stream)
+			return false;
+		const uint64_t size = (uint64_t)m_Stream.tellg();
+		m_Stream.seekg(0);
+
+		EventRecording::FileHeader header = {};
+		if (!m_Stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return false;
+		m_BytesLeft = size - sizeof(header);
+
+		return std::memcmp(header.Magic, EventRecording::Magic, sizeof(header.Magic)) == 0 && header.Version == EventRecording::Version;
+	}
+
+	bool EventReplay::ReadFrame(EventQueue& queue)
+	{
+		if (m_BytesLeft < sizeof(m_Frame) || !m_Stream.read(reinterpret_cast<char*>(&m_Frame), sizeof(m_Frame)))
+			return false;
+		m_BytesLeft -= sizeof(m_Frame);
+
+		// The file is not trusted, nothing is allocated for or dispatched from a corrupt frame
+		const uint64_t eventBytes = (uint64_t)m_Frame.EventCount * sizeof(EventRecording::EventRecord);
+		if (m_Frame.EventCount > EventRecording::MaxEventsPerFrame || eventBytes > m_BytesLeft)
+		{
+			MYGAME_ERROR("Frame {0} of the recording claims {1} events, the file is corrupt or truncated", m_Frame.Frame, m_Frame.EventCount);
+			return false;
+		}
+
+		m_Events.resize(m_Frame.EventCount);
+		if (!m_Stream.read(reinterpret_cast<char*>(m_Events.data()), eventBytes))
+			return false;
+		m_BytesLeft -= eventBytes;
+
+		for (const EventRecording::EventRecord& record : m_Events)
+		{
+			if ((int)record.Event.Type <= (int)EventType::None || (int)record.Event.Type >= EventTypeCount)
+			{
+				MYGAME_ERROR("Frame {0} of the recording has an event of unknown type {1}, the file is corrupt", m_Frame.Frame, (int)record.Event.Type);
+				return false;
+			}
+		}
+
+		for (const EventRecording::EventRecord& record : m_Events)
+			queue.Push(record.Event);
+		m_FramesRead++;
+		return true;
+	}
+}
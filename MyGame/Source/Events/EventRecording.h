@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../Events/EventQueue.h"
+#include "../Events/EventValue.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace MyGame
+{
+	namespace EventRecording
+	{
+		// File layout:
+		//   FileHeader
+		//   { FrameRecord, EventRecord[EventCount] }*
+		// EventValues are stored as is, so files are only portable between builds with the same layout.
+
+		constexpr char Magic[8] = { 'M', 'G', 'E', 'V', 'E', 'N', 'T', '\0' };
+		constexpr uint32_t Version = 1;
+		// Far more than a frame polls, a larger count means the file is corrupt
+		constexpr uint32_t MaxEventsPerFrame = 1 << 16;
+
+#pragma pack(push, 1)
+		struct FileHeader
+		{
+			char Magic[8];
+			uint32_t Version;
+		};
+
+		// Timestamps are nanoseconds since the recording started
+		struct FrameRecord
+		{
+			uint64_t Frame;
+			int64_t Timestamp;
+			float Timestep;
+			uint32_t EventCount;
+		};
+
+		struct EventRecord
+		{
+			int64_t Timestamp;
+			EventValue Event;
+		};
+#pragma pack(pop)
+
+		static_assert(sizeof(EventValue) == 12, "Recordings store EventValues as is, bump Version when the layout changes");
+	}
+
+	// Writes the raw events of the window, before coalescing, with the frame they were polled
+	// in and the frame's timestep. Main thread only.
+	class EventRecorder
+	{
+	public:
+		bool Open(const std::string& filepath);
+		void Close();
+		bool IsOpen() const { return m_Stream.is_open(); }
+
+		void Record(const EventValue& event);
+		// Writes the frame's events, call once per frame before they are dispatched
+		void EndFrame(float timestep);
+
+		uint64_t GetFrameCount() const { return m_Frame; }
+
+	private:
+		int64_t GetTimestamp() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count(); }
+
+	private:
+		std::ofstream m_Stream;
+		std::chrono::steady_clock::time_point m_Start;
+		uint64_t m_Frame = 0;
+		std::vector<EventRecording::EventRecord> m_Events;
+	};
+
+	// Reads a recording back frame by frame, for the headless replay of Application
+	class EventReplay
+	{
+	public:
+		bool Open(const std::string& filepath);
+
+		// Queues the events of the next frame, false at the end of the recording or at a corrupt frame
+		bool ReadFrame(EventQueue& queue);
+		float GetTimestep() const { return m_Frame.Timestep; }
+		uint64_t GetFrame() const { return m_Frame.Frame; }
+		uint64_t GetFramesRead() const { return m_FramesRead; }
+
+	private:
+		std::ifstream m_Stream;
+		uint64_t m_BytesLeft = 0;
+		uint64_t m_FramesRead = 0;
+		EventRecording::FrameRecord m_Frame = {};
+		std::vector<EventRecording::EventRecord> m_Events;
+	};
+}
@@ -0,0 +1,68 @@
+#include "CommonHeaders.h"
+
+#include "EventValue.h"
+
+#include "AppEvent.h"
+#include "KeyEvent.h"
+#include "MouseEvent.h"
+
+namespace MyGame
+{
+	EventValue ToEventValue(const Event& event)
+	{
+		switch (event.GetEventType())
+		{
+		case EventType::WindowResize:
+		{
+			auto& resize = static_cast<const WindowResizeEvent&>(event);
+			return EventValue::WindowResize(resize.GetWidth(), resize.GetHeight());
+		}
+		case EventType::KeyPressed:
+		{
+			auto& key = static_cast<const KeyPressedEvent&>(event);
+			return EventValue::KeyPressed(key.GetKeyCode(), key.IsRepeat());
+		}
+		case EventType::KeyReleased: return EventValue::KeyReleased(static_cast<const KeyEvent&>(event).GetKeyCode());
+		case EventType::KeyTyped: return EventValue::KeyTyped(static_cast<const KeyEvent&>(event).GetKeyCode());
+		case EventType::MouseButtonPressed: return EventValue::MouseButtonPressed(static_cast<const MouseButtonEvent&>(event).GetMouseButton());
+		case EventType::MouseButtonReleased: return EventValue::MouseButtonReleased(static_cast<const MouseButtonEvent&>(event).GetMouseButton());
+		case EventType::MouseMoved:
+		{
+			auto& moved = static_cast<const MouseMovedEvent&>(event);
+			return EventValue::MouseMoved(moved.GetX(), moved.GetY());
+		}
+		case EventType::MouseScrolled:
+		{
+			auto& scrolled = static_cast<const MouseScrolledEvent&>(event);
+			return EventValue::MouseScrolled(scrolled.GetXOffset(), scrolled.GetYOffset());
+		}
+		default: return { event.GetEventType() };
+		}
+	}
+
+	bool DispatchEventValue(const EventValue& value, const std::function<void(Event&)>& callback)
+	{
+		auto dispatch = [&](Event&& event)
+		{
+			callback(event);
+			return event.Handled;
+		};
+
+		switch (value.Type)
+		{
+		case EventType::WindowClose: return dispatch(WindowCloseEvent());
+		case EventType::WindowResize: return dispatch(WindowResizeEvent(value.Size.Width, value.Size.Height));
+		case EventType::AppTick: return dispatch(AppTickEvent());
+		case EventType::AppUpdate: return dispatch(AppUpdateEvent());
+		case EventType::AppRender: return dispatch(AppRenderEvent());
+		case EventType::KeyPressed: return dispatch(KeyPressedEvent(value.Key.KeyCode, value.Key.IsRepeat));
+		case EventType::KeyReleased: return dispatch(KeyReleasedEvent(value.Key.KeyCode));
+		case EventType::KeyTyped: return dispatch(KeyTypedEvent(value.Key.KeyCode));
+		case EventType::MouseButtonPressed: return dispatch(MouseButtonPressedEvent(value.Button.Button));
+		case EventType::MouseButtonReleased: return dispatch(MouseButtonReleasedEvent(value.Button.Button));
+		case EventType::MouseMoved: return dispatch(MouseMovedEvent(value.Cursor.X, value.Cursor.Y));
+		case EventType::MouseScrolled: return dispatch(MouseScrolledEvent(value.Scroll.XOffset, value.Scroll.YOffset));
+		default: return false; // No event class for the type
+		}
+	}
+}
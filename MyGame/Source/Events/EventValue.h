@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../Events/Event.h"
+
+#include "spdlog/fmt/fmt.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+namespace MyGame
+{
+	// Names and categories of every EventType, the same as the event classes report
+	inline constexpr std::array<const char*, EventTypeCount> EventTypeNames =
+	{
+		"None",
+		"WindowClose", "WindowResize", "WindowFocus", "WindowLostFocus", "WindowMoved",
+		"AppTick", "AppUpdate", "AppRender",
+		"KeyPressed", "KeyReleased", "KeyTyped",
+		"MouseButtonPressed", "MouseButtonReleased", "MouseMoved", "MouseScrolled"
+	};
+
+	inline constexpr std::array<int, EventTypeCount> EventTypeCategories =
+	{
+		None,
+		EventCategoryApplication, EventCategoryApplication, EventCategoryApplication, EventCategoryApplication, EventCategoryApplication,
+		EventCategoryApplication, EventCategoryApplication, EventCategoryApplication,
+		EventCategoryKeyboard | EventCategoryInput, EventCategoryKeyboard | EventCategoryInput, EventCategoryKeyboard | EventCategoryInput,
+		EventCategoryMouse | EventCategoryInput | EventCategoryMouseButton, EventCategoryMouse | EventCategoryInput | EventCategoryMouseButton,
+		EventCategoryMouse | EventCategoryInput, EventCategoryMouse | EventCategoryInput
+	};
+
+	constexpr const char* GetEventTypeName(EventType type) { return EventTypeNames[(int)type]; }
+	constexpr int GetEventTypeCategories(EventType type) { return EventTypeCategories[(int)type]; }
+
+	// An event as a small value, the type and a union of the payloads. Trivially copyable, so it
+	// can be stored in queues, ring buffers and files as is, and formatting it doesn't allocate.
+	// Handlers still receive the Event classes, DispatchEventValue builds one on the stack.
+	struct EventValue
+	{
+		struct SizeData { uint32_t Width, Height; };
+		struct KeyData { int KeyCode; bool IsRepeat; };
+		struct ButtonData { int Button; };
+		struct PositionData { float X, Y; };
+		struct OffsetData { float XOffset, YOffset; };
+
+		EventType Type = EventType::None;
+		union
+		{
+			SizeData Size = {}; // WindowResize
+			KeyData Key;        // KeyPressed, KeyReleased, KeyTyped
+			ButtonData Button;  // MouseButtonPressed, MouseButtonReleased
+			PositionData Cursor; // MouseMoved
+			OffsetData Scroll;  // MouseScrolled
+		};
+
+		static constexpr EventValue WindowClose() { return { EventType::WindowClose }; }
+		static constexpr EventValue WindowResize(uint32_t width, uint32_t height) { EventValue value{ EventType::WindowResize }; value.Size = { width, height }; return value; }
+		static constexpr EventValue AppTick() { return { EventType::AppTick }; }
+		static constexpr EventValue AppUpdate() { return { EventType::AppUpdate }; }
+		static constexpr EventValue AppRender() { return { EventType::AppRender }; }
+		static constexpr EventValue KeyPressed(int keycode, bool isRepeat = false) { EventValue value{ EventType::KeyPressed }; value.Key = { keycode, isRepeat }; return value; }
+		static constexpr EventValue KeyReleased(int keycode) { EventValue value{ EventType::KeyReleased }; value.Key = { keycode, false }; return value; }
+		static constexpr EventValue KeyTyped(int keycode) { EventValue value{ EventType::KeyTyped }; value.Key = { keycode, false }; return value; }
+		static constexpr EventValue MouseButtonPressed(int button) { EventValue value{ EventType::MouseButtonPressed }; value.Button = { button }; return value; }
+		static constexpr EventValue MouseButtonReleased(int button) { EventValue value{ EventType::MouseButtonReleased }; value.Button = { button }; return value; }
+		static constexpr EventValue MouseMoved(float x, float y) { EventValue value{ EventType::MouseMoved }; value.Cursor = { x, y }; return value; }
+		static constexpr EventValue MouseScrolled(float xOffset, float yOffset) { EventValue value{ EventType::MouseScrolled }; value.Scroll = { xOffset, yOffset }; return value; }
+
+		constexpr const char* GetName() const { return GetEventTypeName(Type); }
+		constexpr int GetCategoryFlags() const { return GetEventTypeCategories(Type); }
+		constexpr bool IsInCategory(EventCategory category) const { return GetCategoryFlags() & category; }
+	};
+
+	static_assert(std::is_trivially_copyable_v<EventValue>);
+	static_assert(sizeof(EventValue) <= 16);
+
+	EventValue ToEventValue(const Event& event);
+
+	// Runs the callback with the matching Event class, returns whether a handler marked it Handled
+	bool DispatchEventValue(const EventValue& value, const std::function<void(Event&)>& callback);
+}
+
+template<>
+struct fmt::formatter<MyGame::EventValue>
+{
+	constexpr auto parse(fmt::format_parse_context& ctx) { return ctx.begin(); }
+
+	template<typename FormatContext>
+	auto format(const MyGame::EventValue& event, FormatContext& ctx) const
+	{
+		using MyGame::EventType;
+		switch (event.Type)
+		{
+		case EventType::WindowResize: return fmt::format_to(ctx.out(), "{}: {}, {}", event.GetName(), event.Size.Width, event.Size.Height);
+		case EventType::KeyPressed: return fmt::format_to(ctx.out(), "{}: {} - repeat = {}", event.GetName(), event.Key.KeyCode, event.Key.IsRepeat);
+		case EventType::KeyReleased:
+		case EventType::KeyTyped: return fmt::format_to(ctx.out(), "{}: {}", event.GetName(), event.Key.KeyCode);
+		case EventType::MouseButtonPressed:
+		case EventType::MouseButtonReleased: return fmt::format_to(ctx.out(), "{}: {}", event.GetName(), event.Button.Button);
+		case EventType::MouseMoved: return fmt::format_to(ctx.out(), "{}: {}, {}", event.GetName(), event.Cursor.X, event.Cursor.Y);
+		case EventType::MouseScrolled: return fmt::format_to(ctx.out(), "{}: {}, {}", event.GetName(), event.Scroll.XOffset, event.Scroll.YOffset);
+		default: return fmt::format_to(ctx.out(), "{}", event.GetName());
+		}
+	}
+};
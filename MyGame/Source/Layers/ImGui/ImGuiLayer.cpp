@@ -24,7 +24,11 @@
 
 namespace MyGame
 {
-	ImGuiLayer::ImGuiLayer() : Layer("ImGuiLayer") {}
+	ImGuiLayer::ImGuiLayer() : Layer("ImGuiLayer")
+	{
+		// Only blocks input from the layers below
+		Subscribe(EventCategoryMouse | EventCategoryKeyboard);
+	}
 
 	void ImGuiLayer::OnAttach()
 	{
@@ -100,6 +104,8 @@ namespace MyGame
 		// MSAA
 		ImGui::Text("MSAA Quality");
 		ImGui::SliderInt(" ", &temp1, 0, 8);
+
+		m_ProfilerPanel.OnImGuiRender();
 	}
 
 	void ImGuiLayer::Begin()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../Core/Layer.h"
+#include "ProfilerPanel.h"
 
 #include "../../Events/AppEvent.h"
 #include "../../Events/EventCodes/KeyCodes.h"
@@ -29,5 +30,7 @@ namespace MyGame
 
 	private:
 		bool m_BlockEvents = true;
+
+		ProfilerPanel m_ProfilerPanel;
 	};
 }
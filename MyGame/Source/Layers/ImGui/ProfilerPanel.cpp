@@ -0,0 +1,615 @@
+#include "CommonHeaders.h"
+
+#include "ProfilerPanel.h"
+#include "../../Debugs/InputLatency.h"
+
+#include <imgui.h>
+
+#include <cmath>
+#include <limits>
+
+namespace MyGame
+{
+	static constexpr float s_TimelineRowHeight = 18.0f;
+	static constexpr float s_TimelineLabelWidth = 120.0f;
+
+	static float ToMilliseconds(int64_t nanoseconds) { return nanoseconds / 1'000'000.0f; }
+
+	void ProfilerPanel::OnImGuiRender()
+	{
+		ImGui::Begin("Profiler");
+
+		bool recording = Instrumentor::Get().IsLiveCaptureEnabled();
+		if (ImGui::Checkbox("Record", &recording))
+			Instrumentor::Get().SetLiveCapture(recording);
+
+		ImGui::SameLine();
+		bool perfCounters = Instrumentor::ArePerfCountersEnabled();
+		if (ImGui::Checkbox("Perf counters", &perfCounters))
+			Instrumentor::SetPerfCountersEnabled(perfCounters);
+
+		ImGui::SameLine();
+		ImGui::Checkbox("Pause", &m_Paused);
+		ImGui::SameLine();
+		if (ImGui::Button("Latest"))
+		{
+			m_Paused = false;
+			m_FollowLatest = true;
+		}
+		ImGui::SameLine();
+		ImGui::PushItemWidth(100);
+		ImGui::DragFloat("Pause on spike (ms)", &m_PauseOnSpikeMs, 0.5f, 0.0f, 1000.0f, "%.1f");
+		ImGui::PopItemWidth();
+
+		PullFrames();
+
+		if (Instrumentor::IsCollectingStatistics() && ImGui::CollapsingHeader("Statistics"))
+			DrawStatistics();
+		if (ImGui::CollapsingHeader("Input Latency"))
+			DrawInputLatency();
+
+		if (m_Frames.empty())
+		{
+			ImGui::TextUnformatted(recording ? "Waiting for frames..." : "Enable Record to capture the last frames.");
+			ImGui::End();
+			return;
+		}
+
+		DrawFrameGraph();
+
+		const ProfileFrame* frame = FindFrame(m_SelectedFrame);
+		if (frame && m_CallTreeFrame != frame->Index)
+			BuildCallTrees(*frame);
+
+		if (ImGui::CollapsingHeader("Timeline", ImGuiTreeNodeFlags_DefaultOpen))
+			DrawTimeline();
+		if (ImGui::CollapsingHeader("Call Tree", ImGuiTreeNodeFlags_DefaultOpen))
+			DrawCallTree();
+		if (ImGui::CollapsingHeader("Utilization"))
+			DrawUtilization();
+		if (ImGui::CollapsingHeader("Counters"))
+			DrawCounters();
+
+		ImGui::End();
+	}
+
+	void ProfilerPanel::PullFrames()
+	{
+		if (m_Paused)
+			return;
+
+		const size_t firstNew = m_Frames.size();
+		m_NextFrameIndex = Instrumentor::Get().CopyFrameHistory(m_NextFrameIndex, m_Frames);
+		m_Threads = Instrumentor::Get().GetThreads();
+
+		for (size_t i = firstNew; i < m_Frames.size(); i++)
+		{
+			if (m_PauseOnSpikeMs > 0.0f && ToMilliseconds(m_Frames[i].Duration) > m_PauseOnSpikeMs)
+			{
+				m_Paused = true;
+				m_FollowLatest = false;
+				m_SelectedFrame = m_Frames[i].Index;
+				break;
+			}
+		}
+
+		if (m_Frames.size() > Instrumentor::LiveFrameCount)
+			m_Frames.erase(m_Frames.begin(), m_Frames.end() - Instrumentor::LiveFrameCount);
+
+		if (m_FollowLatest && !m_Frames.empty())
+			m_SelectedFrame = m_Frames.back().Index;
+	}
+
+	std::string ProfilerPanel::GetThreadLabel(uint32_t threadIndex) const
+	{
+		if (threadIndex >= m_Threads.size())
+			return "Thread " + std::to_string(threadIndex);
+		if (!m_Threads[threadIndex].Name.empty())
+			return m_Threads[threadIndex].Name;
+		return "Thread " + std::to_string(m_Threads[threadIndex].ThreadID);
+	}
+
+	const ProfileFrame* ProfilerPanel::FindFrame(uint64_t frameIndex) const
+	{
+		auto it = std::lower_bound(m_Frames.begin(), m_Frames.end(), frameIndex, [](const ProfileFrame& frame, uint64_t index) { return frame.Index < index; });
+		return it != m_Frames.end() && it->Index == frameIndex ? &*it : nullptr;
+	}
+
+	void ProfilerPanel::BuildCallTrees(const ProfileFrame& frame)
+	{
+		m_CallTrees.clear();
+		m_CallTreeFrame = frame.Index;
+
+		std::vector<ProfileFrame::Event> events;
+		std::copy_if(frame.Events.begin(), frame.Events.end(), std::back_inserter(events), [](const ProfileFrame::Event& event) { return event.Result.Type == ProfileResultType::Scope; });
+		std::sort(events.begin(), events.end(), [](const ProfileFrame::Event& a, const ProfileFrame::Event& b)
+			{
+				if (a.ThreadIndex != b.ThreadIndex)
+					return a.ThreadIndex < b.ThreadIndex;
+				if (a.Result.Start != b.Result.Start)
+					return a.Result.Start < b.Result.Start;
+				return a.Result.ElapsedTime > b.Result.ElapsedTime; // Parents before children starting at the same time
+			});
+
+		// Scopes nest, so a stack of open scopes is enough to find every parent
+		std::vector<std::pair<uint32_t, int64_t>> stack;
+		for (const ProfileFrame::Event& event : events)
+		{
+			if (m_CallTrees.empty() || m_CallTrees.back().ThreadIndex != event.ThreadIndex)
+			{
+				m_CallTrees.push_back({ event.ThreadIndex, { CallNode() } });
+				stack.clear();
+			}
+
+			std::vector<CallNode>& nodes = m_CallTrees.back().Nodes;
+			while (!stack.empty() && stack.back().second <= event.Result.Start)
+				stack.pop_back();
+
+			const uint32_t parent = stack.empty() ? 0 : stack.back().first;
+
+			// Calls of the same scope under the same parent are merged into one node
+			uint32_t node = 0;
+			for (uint32_t child : nodes[parent].Children)
+			{
+				if (nodes[child].ScopeID == event.Result.ScopeID)
+				{
+					node = child;
+					break;
+				}
+			}
+			if (!node)
+			{
+				node = (uint32_t)nodes.size();
+				CallNode& created = nodes.emplace_back();
+				created.Name = event.Name;
+				created.ScopeID = event.Result.ScopeID;
+				nodes[parent].Children.push_back(node);
+			}
+
+			nodes[node].Inclusive += event.Result.ElapsedTime;
+			nodes[node].Calls++;
+			stack.emplace_back(node, event.Result.Start + event.Result.ElapsedTime);
+		}
+
+		for (ThreadCallTree& tree : m_CallTrees)
+		{
+			for (CallNode& node : tree.Nodes)
+			{
+				node.Exclusive = node.Inclusive;
+				for (uint32_t child : node.Children)
+					node.Exclusive -= tree.Nodes[child].Inclusive;
+			}
+
+			for (CallNode& node : tree.Nodes)
+				std::sort(node.Children.begin(), node.Children.end(), [&](uint32_t a, uint32_t b) { return tree.Nodes[a].Inclusive > tree.Nodes[b].Inclusive; });
+		}
+	}
+
+	void ProfilerPanel::DrawFrameGraph()
+	{
+		std::vector<float> frameTimes(m_Frames.size());
+		float maxFrameTime = 0.0f;
+		for (size_t i = 0; i < m_Frames.size(); i++)
+		{
+			frameTimes[i] = ToMilliseconds(m_Frames[i].Duration);
+			maxFrameTime = std::max(maxFrameTime, frameTimes[i]);
+		}
+
+		const ProfileFrame* selected = FindFrame(m_SelectedFrame);
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "Frame %llu: %.3f ms", (unsigned long long)m_SelectedFrame, selected ? ToMilliseconds(selected->Duration) : 0.0f);
+
+		ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), (int)frameTimes.size(), 0, overlay, 0.0f, maxFrameTime * 1.1f, ImVec2(ImGui::GetContentRegionAvail().x, 80.0f));
+
+		// Clicking a bar selects that frame and stops following the newest one
+		if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+		{
+			const float x = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / ImGui::GetItemRectSize().x;
+			const size_t index = std::min((size_t)(std::max(x, 0.0f) * m_Frames.size()), m_Frames.size() - 1);
+			m_SelectedFrame = m_Frames[index].Index;
+			m_FollowLatest = false;
+		}
+	}
+
+	void ProfilerPanel::DrawCallTree()
+	{
+		const ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg;
+		if (!ImGui::BeginTable("##CallTree", 4, flags))
+			return;
+
+		ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Inclusive (ms)", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+		ImGui::TableSetupColumn("Exclusive (ms)", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+		ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+		ImGui::TableHeadersRow();
+
+		for (const ThreadCallTree& tree : m_CallTrees)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+
+			const bool open = ImGui::TreeNodeEx((void*)(uintptr_t)tree.ThreadIndex, ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen, "%s", GetThreadLabel(tree.ThreadIndex).c_str());
+			if (open)
+			{
+				for (uint32_t child : tree.Nodes[0].Children)
+					DrawCallNode(tree, child);
+				ImGui::TreePop();
+			}
+		}
+
+		ImGui::EndTable();
+	}
+
+	void ProfilerPanel::DrawCallNode(const ThreadCallTree& tree, uint32_t nodeIndex)
+	{
+		const CallNode& node = tree.Nodes[nodeIndex];
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+
+		ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth;
+		if (node.Children.empty())
+			flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+		const bool open = ImGui::TreeNodeEx((void*)(uintptr_t)nodeIndex, flags, "%s", node.Name);
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", ToMilliseconds(node.Inclusive));
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", ToMilliseconds(node.Exclusive));
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", node.Calls);
+
+		if (open && !node.Children.empty())
+		{
+			for (uint32_t child : node.Children)
+				DrawCallNode(tree, child);
+			ImGui::TreePop();
+		}
+	}
+
+	void ProfilerPanel::DrawTimeline()
+	{
+		ImGui::PushItemWidth(200);
+		ImGui::SliderInt("Frames", &m_TimelineFrames, 1, 32);
+		ImGui::PopItemWidth();
+
+		auto last = std::lower_bound(m_Frames.begin(), m_Frames.end(), m_SelectedFrame, [](const ProfileFrame& frame, uint64_t index) { return frame.Index < index; });
+		if (last == m_Frames.end())
+			return;
+		auto first = last - std::min<ptrdiff_t>(m_TimelineFrames - 1, last - m_Frames.begin());
+
+		const int64_t rangeStart = first->Start;
+		const int64_t rangeEnd = last->Start + last->Duration;
+		if (rangeEnd <= rangeStart)
+			return;
+
+		// Depth of every event per thread, same stack walk as the call tree
+		struct TimelineEvent
+		{
+			const ProfileFrame::Event* Event;
+			uint32_t Depth;
+		};
+		std::vector<std::vector<TimelineEvent>> threads;
+		{
+			std::vector<const ProfileFrame::Event*> events;
+			for (auto it = first; it <= last; ++it)
+				for (const ProfileFrame::Event& event : it->Events)
+					if (event.Result.Type == ProfileResultType::Scope)
+						events.push_back(&event);
+
+			std::sort(events.begin(), events.end(), [](const ProfileFrame::Event* a, const ProfileFrame::Event* b)
+				{
+					if (a->Result.Start != b->Result.Start)
+						return a->Result.Start < b->Result.Start;
+					return a->Result.ElapsedTime > b->Result.ElapsedTime;
+				});
+
+			std::vector<std::vector<int64_t>> stacks;
+			for (const ProfileFrame::Event* event : events)
+			{
+				if (event->ThreadIndex >= threads.size())
+				{
+					threads.resize(event->ThreadIndex + 1);
+					stacks.resize(event->ThreadIndex + 1);
+				}
+
+				std::vector<int64_t>& stack = stacks[event->ThreadIndex];
+				while (!stack.empty() && stack.back() <= event->Result.Start)
+					stack.pop_back();
+
+				threads[event->ThreadIndex].push_back({ event, (uint32_t)stack.size() });
+				stack.push_back(event->Result.Start + event->Result.ElapsedTime);
+			}
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float width = std::max(ImGui::GetContentRegionAvail().x - s_TimelineLabelWidth, 1.0f);
+		const double scale = width / (double)(rangeEnd - rangeStart);
+		const ImU32 barColor = ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+		const ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+
+		float y = origin.y;
+		for (uint32_t threadIndex = 0; threadIndex < threads.size(); threadIndex++)
+		{
+			if (threads[threadIndex].empty())
+				continue;
+
+			const std::string label = GetThreadLabel(threadIndex);
+			drawList->AddText(ImVec2(origin.x, y), textColor, label.c_str());
+
+			uint32_t maxDepth = 0;
+			for (const TimelineEvent& event : threads[threadIndex])
+			{
+				maxDepth = std::max(maxDepth, event.Depth);
+				const ProfileResult& result = event.Event->Result;
+
+				const float x0 = origin.x + s_TimelineLabelWidth + (float)((result.Start - rangeStart) * scale);
+				const float x1 = std::max(x0 + 1.0f, origin.x + s_TimelineLabelWidth + (float)((result.Start + result.ElapsedTime - rangeStart) * scale));
+				const ImVec2 min(x0, y + event.Depth * s_TimelineRowHeight);
+				const ImVec2 max(x1, min.y + s_TimelineRowHeight - 1.0f);
+
+				drawList->AddRectFilled(min, max, barColor);
+				if (x1 - x0 > 20.0f)
+				{
+					drawList->PushClipRect(min, max, true);
+					drawList->AddText(ImVec2(x0 + 2.0f, min.y + 1.0f), textColor, event.Event->Name);
+					drawList->PopClipRect();
+				}
+
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s\n%.3f ms", event.Event->Name, ToMilliseconds(result.ElapsedTime));
+			}
+
+			y += (maxDepth + 1) * s_TimelineRowHeight + 4.0f;
+		}
+
+		// Frame boundaries
+		for (auto it = first; it <= last; ++it)
+		{
+			const float x = origin.x + s_TimelineLabelWidth + (float)((it->Start - rangeStart) * scale);
+			drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, y), ImGui::GetColorU32(ImGuiCol_Separator));
+		}
+
+		ImGui::Dummy(ImVec2(width + s_TimelineLabelWidth, y - origin.y));
+	}
+
+	void ProfilerPanel::DrawUtilization()
+	{
+		// Each thread's CPU time per frame in percent of the frame, the total is the number of cores kept busy
+		struct ThreadTrack
+		{
+			uint32_t ThreadIndex = 0;
+			std::vector<float> Values;
+			float Sum = 0.0f;
+			float Peak = 0.0f;
+			uint32_t Count = 0;
+		};
+
+		std::vector<ThreadTrack> tracks;
+		for (uint32_t threadIndex = 0; threadIndex < m_Threads.size(); threadIndex++)
+			if (m_Threads[threadIndex].UtilizationScopeID)
+				tracks.push_back({ threadIndex, std::vector<float>(m_Frames.size(), 0.0f) });
+
+		std::vector<float> total(m_Frames.size(), 0.0f);
+		for (size_t frameIndex = 0; frameIndex < m_Frames.size(); frameIndex++)
+		{
+			for (const ProfileFrame::Event& event : m_Frames[frameIndex].Events)
+			{
+				if (event.Result.Type != ProfileResultType::Counter)
+					continue;
+
+				for (ThreadTrack& track : tracks)
+				{
+					if (event.Result.ScopeID != m_Threads[track.ThreadIndex].UtilizationScopeID)
+						continue;
+
+					const float value = (float)event.Result.Value;
+					track.Values[frameIndex] = value;
+					track.Sum += value;
+					track.Peak = std::max(track.Peak, value);
+					track.Count++;
+					total[frameIndex] += value;
+					break;
+				}
+			}
+		}
+
+		if (tracks.empty())
+		{
+			ImGui::TextUnformatted("No utilization recorded yet.");
+			return;
+		}
+
+		const size_t selected = FindFrame(m_SelectedFrame) ? FindFrame(m_SelectedFrame) - m_Frames.data() : m_Frames.size() - 1;
+		const ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_RowBg;
+		if (!ImGui::BeginTable("##Utilization", 5, flags))
+			return;
+
+		ImGui::TableSetupColumn("Thread", ImGuiTableColumnFlags_WidthFixed, s_TimelineLabelWidth);
+		ImGui::TableSetupColumn("Frame (%)", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+		ImGui::TableSetupColumn("Mean (%)", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+		ImGui::TableSetupColumn("Peak (%)", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+		ImGui::TableSetupColumn("History", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableHeadersRow();
+
+		float totalSum = 0.0f;
+		for (const ThreadTrack& track : tracks)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(GetThreadLabel(track.ThreadIndex).c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", track.Values[selected]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", track.Count ? track.Sum / track.Count : 0.0f);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", track.Peak);
+			ImGui::TableNextColumn();
+			ImGui::PushID((int)track.ThreadIndex);
+			ImGui::PlotLines("##Utilization", track.Values.data(), (int)track.Values.size(), 0, nullptr, 0.0f, 100.0f, ImVec2(ImGui::GetContentRegionAvail().x, 20.0f));
+			ImGui::PopID();
+			totalSum += track.Count ? track.Sum / track.Count : 0.0f;
+		}
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted("Total");
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", total[selected]);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", totalSum);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", *std::max_element(total.begin(), total.end()));
+		ImGui::TableNextColumn();
+		ImGui::PlotLines("##Total", total.data(), (int)total.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 20.0f));
+
+		ImGui::EndTable();
+	}
+
+	void ProfilerPanel::UpdateCounterTracks()
+	{
+		// Frames before firstNew are in the tracks already, the ones trimmed from m_Frames since go
+		auto firstNewIt = std::lower_bound(m_Frames.begin(), m_Frames.end(), m_CounterFrameEnd, [](const ProfileFrame& frame, uint64_t index) { return frame.Index < index; });
+		size_t firstNew = firstNewIt - m_Frames.begin();
+		if (firstNew > m_CounterFrameCount)
+		{
+			// Not a continuation of the frames in the tracks, start over
+			m_CounterTracks.clear();
+			m_CounterTrackIndices.clear();
+			m_CounterFrameCount = 0;
+			firstNew = 0;
+		}
+
+		// Frames without a sample of their own are NaN until the forward fill below
+		const float unset = std::numeric_limits<float>::quiet_NaN();
+		const size_t trimmed = m_CounterFrameCount - firstNew;
+		for (CounterTrack& track : m_CounterTracks)
+		{
+			track.Values.erase(track.Values.begin(), track.Values.begin() + trimmed);
+			track.Values.resize(m_Frames.size(), unset);
+		}
+
+		for (size_t frameIndex = firstNew; frameIndex < m_Frames.size(); frameIndex++)
+		{
+			for (const ProfileFrame::Event& event : m_Frames[frameIndex].Events)
+			{
+				if (event.Result.Type != ProfileResultType::Counter)
+					continue;
+
+				auto [it, inserted] = m_CounterTrackIndices.try_emplace(event.Result.ScopeID, m_CounterTracks.size());
+				if (inserted)
+				{
+					CounterTrack& track = m_CounterTracks.emplace_back(CounterTrack{ event.Result.ScopeID, event.Name, std::vector<float>(m_Frames.size(), 0.0f) });
+					std::fill(track.Values.begin() + frameIndex, track.Values.end(), unset);
+				}
+				m_CounterTracks[it->second].Values[frameIndex] = (float)event.Result.Value;
+			}
+		}
+
+		for (CounterTrack& track : m_CounterTracks)
+		{
+			for (size_t frameIndex = firstNew; frameIndex < track.Values.size(); frameIndex++)
+			{
+				if (std::isnan(track.Values[frameIndex]))
+					track.Values[frameIndex] = track.LastValue;
+				track.LastValue = track.Values[frameIndex];
+			}
+		}
+
+		m_CounterFrameCount = m_Frames.size();
+		if (!m_Frames.empty())
+			m_CounterFrameEnd = m_Frames.back().Index + 1;
+	}
+
+	void ProfilerPanel::DrawCounters()
+	{
+		// One track per counter name, each frame shows the last sample taken up to its end
+		UpdateCounterTracks();
+		if (m_CounterTracks.empty() || m_Frames.empty())
+		{
+			ImGui::TextUnformatted("No counters recorded, see MYGAME_PROFILE_COUNTER.");
+			return;
+		}
+
+		const size_t selected = FindFrame(m_SelectedFrame) ? FindFrame(m_SelectedFrame) - m_Frames.data() : m_Frames.size() - 1;
+		for (size_t trackIndex = 0; trackIndex < m_CounterTracks.size(); trackIndex++)
+		{
+			const CounterTrack& track = m_CounterTracks[trackIndex];
+			char overlay[128];
+			snprintf(overlay, sizeof(overlay), "%s: %.2f", track.Name, track.Values[selected]);
+
+			ImGui::PushID((int)trackIndex);
+			ImGui::PlotLines("##Counter", track.Values.data(), (int)track.Values.size(), 0, overlay, FLT_MAX, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 40.0f));
+			ImGui::PopID();
+		}
+	}
+
+	void ProfilerPanel::DrawInputLatency()
+	{
+		if (!InputLatency::GetSampleCount())
+		{
+			ImGui::TextUnformatted("No input presented yet.");
+			return;
+		}
+
+		ImGui::Text("Last %.2f ms   p50 %.0f ms   p95 %.0f ms   p99 %.0f ms   (%llu frames)", InputLatency::GetLastMilliseconds(),
+			InputLatency::GetPercentileMilliseconds(50.0f), InputLatency::GetPercentileMilliseconds(95.0f), InputLatency::GetPercentileMilliseconds(99.0f),
+			(unsigned long long)InputLatency::GetSampleCount());
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Reset"))
+			InputLatency::Reset();
+
+		// Trailing empty buckets are cut so the shape stays readable
+		const auto& histogram = InputLatency::GetHistogram();
+		int bucketCount = InputLatency::BucketCount;
+		while (bucketCount > 1 && histogram[bucketCount - 1] == 0)
+			bucketCount--;
+
+		std::array<float, InputLatency::BucketCount> buckets;
+		for (int i = 0; i < bucketCount; i++)
+			buckets[i] = (float)histogram[i];
+		ImGui::PlotHistogram("##InputLatency", buckets.data(), bucketCount, 0, "1 ms buckets", 0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+	}
+
+	void ProfilerPanel::DrawStatistics()
+	{
+		if (ImGui::Button("Write snapshot"))
+			Instrumentor::Get().WriteStatistics();
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+		if (!ImGui::BeginTable("##Statistics", 9, flags, ImVec2(0.0f, 250.0f)))
+			return;
+
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+		for (const char* column : { "Calls", "Mean (us)", "P50 (us)", "P99 (us)", "P99.9 (us)", "Max (us)", "IPC", "Cache misses" })
+			ImGui::TableSetupColumn(column, ImGuiTableColumnFlags_WidthFixed, 80.0f);
+		ImGui::TableHeadersRow();
+
+		for (const ScopeSummary& summary : Instrumentor::Get().GetStatistics())
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(summary.Name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)summary.Count);
+			for (double value : { summary.GetMean(), (double)summary.GetPercentile(50.0), (double)summary.GetPercentile(99.0), (double)summary.GetPercentile(99.9), (double)summary.Max })
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", value / 1000.0);
+			}
+
+			// Per call, MYGAME_PROFILE_SCOPE_COUNTERS sites only
+			ImGui::TableNextColumn();
+			if (summary.HasCounters())
+				ImGui::Text("%.2f", summary.GetIPC());
+			ImGui::TableNextColumn();
+			if (summary.HasCounters())
+				ImGui::Text("%.0f", summary.GetPerCall(summary.CacheMisses));
+		}
+
+		ImGui::EndTable();
+	}
+}
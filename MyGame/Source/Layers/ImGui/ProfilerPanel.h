@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../../Debugs/Instrumentor.h"
+
+namespace MyGame
+{
+	// Live view of the Instrumentor's frame history: frame time graph,
+	// per-frame call tree, per-thread timeline, CPU utilization and counter tracks
+	class ProfilerPanel
+	{
+	public:
+		void OnImGuiRender();
+
+	private:
+		struct CallNode
+		{
+			const char* Name = nullptr;
+			uint32_t ScopeID = 0;
+			int64_t Inclusive = 0;
+			int64_t Exclusive = 0;
+			uint32_t Calls = 0;
+			std::vector<uint32_t> Children;
+		};
+
+		struct ThreadCallTree
+		{
+			uint32_t ThreadIndex = 0;
+			std::vector<CallNode> Nodes; // Nodes[0] is the root
+		};
+
+		struct CounterTrack
+		{
+			uint32_t ScopeID = 0;
+			const char* Name = nullptr;
+			std::vector<float> Values; // One per frame of m_Frames, the last sample taken up to its end
+			float LastValue = 0.0f;    // Of the newest frame, carried into the following ones
+		};
+
+		void PullFrames();
+		const ProfileFrame* FindFrame(uint64_t frameIndex) const;
+		void BuildCallTrees(const ProfileFrame& frame);
+		void UpdateCounterTracks();
+		std::string GetThreadLabel(uint32_t threadIndex) const;
+
+		void DrawFrameGraph();
+		void DrawCallTree();
+		void DrawCallNode(const ThreadCallTree& tree, uint32_t nodeIndex);
+		void DrawTimeline();
+		void DrawUtilization();
+		void DrawCounters();
+		void DrawStatistics();
+		void DrawInputLatency();
+
+	private:
+		std::vector<ProfileFrame> m_Frames;
+		std::vector<ProfileThreadInfo> m_Threads;
+		uint64_t m_NextFrameIndex = 0;
+
+		uint64_t m_SelectedFrame = 0;
+		bool m_FollowLatest = true;
+		bool m_Paused = false;
+		float m_PauseOnSpikeMs = 0.0f;
+		int m_TimelineFrames = 1;
+
+		std::vector<ThreadCallTree> m_CallTrees;
+		uint64_t m_CallTreeFrame = UINT64_MAX;
+
+		// Extended with the frames pulled since the last render, trimmed along with m_Frames
+		std::vector<CounterTrack> m_CounterTracks;
+		std::unordered_map<uint32_t, size_t> m_CounterTrackIndices; // By scope ID
+		size_t m_CounterFrameCount = 0;
+		uint64_t m_CounterFrameEnd = 0; // Index after the last frame in the tracks
+	};
+}
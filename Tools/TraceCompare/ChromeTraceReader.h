@@ -0,0 +1,265 @@
+#pragma once
+
+// Reads the complete ("ph":"X") events of a Chrome / Perfetto JSON trace into a TraceFile::Trace,
+// so JSON sessions, hitch dumps and converted .mgtrace files can be handled like binary ones.
+// Only what the Instrumentor writes is interpreted, other events and fields are skipped.
+
+#include "Debugs/TraceFile.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+namespace MyGame::ChromeTraceReader
+{
+	class Parser
+	{
+	public:
+		Parser(std::string_view text) : m_Text(text) {}
+
+		bool Parse(TraceFile::Trace& trace)
+		{
+			SkipWhitespace();
+			if (Peek() == '[')
+				return ParseEvents(trace);
+			if (!Consume('{'))
+				return false;
+
+			// Object form, the events are in "traceEvents"
+			while (true)
+			{
+				SkipWhitespace();
+				if (Consume('}'))
+					return false;
+
+				std::string key;
+				if (!ParseString(key) || !ConsumeToken(':'))
+					return false;
+
+				SkipWhitespace();
+				if (key == "traceEvents")
+					return ParseEvents(trace);
+				if (!SkipValue())
+					return false;
+
+				SkipWhitespace();
+				Consume(',');
+			}
+		}
+
+	private:
+		bool ParseEvents(TraceFile::Trace& trace)
+		{
+			if (!Consume('['))
+				return false;
+
+			while (true)
+			{
+				SkipWhitespace();
+				if (Consume(']'))
+					return true;
+				if (!ParseEvent(trace))
+					return false;
+
+				SkipWhitespace();
+				Consume(',');
+			}
+		}
+
+		bool ParseEvent(TraceFile::Trace& trace)
+		{
+			if (!Consume('{'))
+				return SkipValue();
+
+			std::string name, phase;
+			double timestamp = 0.0, duration = 0.0, threadID = 0.0;
+			while (true)
+			{
+				SkipWhitespace();
+				if (Consume('}'))
+					break;
+
+				std::string key;
+				if (!ParseString(key) || !ConsumeToken(':'))
+					return false;
+
+				SkipWhitespace();
+				bool parsed = true;
+				if (key == "name")
+					parsed = ParseString(name);
+				else if (key == "ph")
+					parsed = ParseString(phase);
+				else if (key == "ts")
+					parsed = ParseNumber(timestamp);
+				else if (key == "dur")
+					parsed = ParseNumber(duration);
+				else if (key == "tid")
+					parsed = ParseNumber(threadID);
+				else
+					parsed = SkipValue();
+				if (!parsed)
+					return false;
+
+				SkipWhitespace();
+				Consume(',');
+			}
+
+			if (phase != "X")
+				return true;
+
+			// Microseconds in JSON, nanoseconds in a Trace
+			const int64_t start = (int64_t)(timestamp * 1000.0);
+			const int64_t length = (int64_t)(duration * 1000.0);
+			const uint32_t threadIndex = GetThreadIndex(trace, (uint64_t)threadID);
+			if (name == "Frame" || name == "Frame (hitch)")
+			{
+				trace.Frames.push_back({ threadIndex, start, length });
+			}
+			else
+			{
+				const uint32_t nameID = TraceFile::HashName(name);
+				trace.Names.try_emplace(nameID, name);
+				trace.Scopes.push_back({ nameID, threadIndex, start, length });
+			}
+			return true;
+		}
+
+		uint32_t GetThreadIndex(TraceFile::Trace& trace, uint64_t threadID)
+		{
+			for (auto& [index, id] : trace.Threads)
+				if (id == threadID)
+					return index;
+
+			const uint32_t index = (uint32_t)trace.Threads.size();
+			trace.Threads[index] = threadID;
+			return index;
+		}
+
+		bool ParseString(std::string& value)
+		{
+			if (!Consume('"'))
+				return false;
+
+			value.clear();
+			while (m_Position < m_Text.size())
+			{
+				const char c = m_Text[m_Position++];
+				if (c == '"')
+					return true;
+				if (c == '\\' && m_Position < m_Text.size())
+				{
+					const char escaped = m_Text[m_Position++];
+					switch (escaped)
+					{
+					case 'n': value += '\n'; break;
+					case 't': value += '\t'; break;
+					case 'r': value += '\r'; break;
+					case 'b': value += '\b'; break;
+					case 'f': value += '\f'; break;
+					case 'u': m_Position += 4; value += '?'; break; // Not needed for scope names
+					default: value += escaped; break;
+					}
+				}
+				else
+				{
+					value += c;
+				}
+			}
+			return false;
+		}
+
+		bool ParseNumber(double& value)
+		{
+			size_t end = m_Position;
+			while (end < m_Text.size() && (std::isdigit((unsigned char)m_Text[end]) || std::strchr("+-.eE", m_Text[end])))
+				end++;
+
+			if (std::from_chars(m_Text.data() + m_Position, m_Text.data() + end, value).ec != std::errc())
+				return false;
+
+			m_Position = end;
+			return true;
+		}
+
+		bool SkipValue()
+		{
+			SkipWhitespace();
+			const char c = Peek();
+			if (c == '"')
+			{
+				std::string ignored;
+				return ParseString(ignored);
+			}
+			if (c == '{' || c == '[')
+			{
+				const char close = c == '{' ? '}' : ']';
+				m_Position++;
+				while (true)
+				{
+					SkipWhitespace();
+					if (Consume(close))
+						return true;
+					if (c == '{')
+					{
+						std::string ignored;
+						if (!ParseString(ignored) || !ConsumeToken(':'))
+							return false;
+					}
+					if (!SkipValue())
+						return false;
+
+					SkipWhitespace();
+					Consume(',');
+				}
+			}
+
+			// Number, true, false or null
+			const size_t start = m_Position;
+			while (m_Position < m_Text.size() && !std::strchr(",}] \t\r\n", m_Text[m_Position]))
+				m_Position++;
+			return m_Position != start;
+		}
+
+		void SkipWhitespace()
+		{
+			while (m_Position < m_Text.size() && std::isspace((unsigned char)m_Text[m_Position]))
+				m_Position++;
+		}
+
+		char Peek() const { return m_Position < m_Text.size() ? m_Text[m_Position] : '\0'; }
+
+		bool Consume(char c)
+		{
+			if (Peek() != c)
+				return false;
+			m_Position++;
+			return true;
+		}
+
+		bool ConsumeToken(char c)
+		{
+			SkipWhitespace();
+			return Consume(c);
+		}
+
+	private:
+		std::string_view m_Text;
+		size_t m_Position = 0;
+	};
+
+	// Also accepts a trace cut off mid-write, everything parsed until then is kept
+	inline bool Read(const std::string& filepath, TraceFile::Trace& trace)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+			return false;
+
+		std::stringstream contents;
+		contents << stream.rdbuf();
+		const std::string text = contents.str();
+
+		Parser(text).Parse(trace);
+		return !trace.Scopes.empty() || !trace.Frames.empty();
+	}
+}
@@ -0,0 +1,235 @@
+// Compares two Instrumentor captures scope by scope to find performance regressions.
+// Usage: TraceCompare <baseline> <candidate> [--csv <path>] [--json <path>] [--top <count>] [--fail-above <percent>]
+//
+// Captures can be binary sessions (.mgtrace) or Chrome JSON (sessions, hitch dumps, converted traces).
+// Scopes are matched by name. When both captures have frame marks, times and call counts are per
+// frame, otherwise per capture. Scopes are sorted by the absolute change of their time per frame.
+
+#include "ChromeTraceReader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+using namespace MyGame;
+
+struct ScopeTimes
+{
+	uint64_t Calls = 0;
+	int64_t Total = 0;
+	std::vector<int64_t> Durations;
+
+	double GetMean() const { return Calls ? (double)Total / Calls : 0.0; }
+
+	// Nearest rank, Durations must be sorted
+	int64_t GetPercentile(double percentile) const
+	{
+		if (Durations.empty())
+			return 0;
+		const size_t rank = (size_t)std::ceil(percentile / 100.0 * Durations.size());
+		return Durations[std::clamp<size_t>(rank, 1, Durations.size()) - 1];
+	}
+};
+
+struct Capture
+{
+	std::string Path;
+	uint64_t FrameCount = 0;
+	std::map<std::string, ScopeTimes> Scopes;
+};
+
+struct ScopeDelta
+{
+	std::string Name;
+	const ScopeTimes* Baseline;
+	const ScopeTimes* Candidate;
+
+	// Milliseconds of scope time per frame (or per capture), the sort key
+	double BaselineTime;
+	double CandidateTime;
+
+	double GetImpact() const { return CandidateTime - BaselineTime; }
+	double GetChangePercent() const { return BaselineTime > 0.0 ? (CandidateTime - BaselineTime) / BaselineTime * 100.0 : 0.0; }
+};
+
+static bool LoadCapture(const std::string& path, Capture& capture)
+{
+	TraceFile::Trace trace;
+	const bool loaded = TraceFile::IsBinaryPath(path) ? TraceFile::Read(path, trace) : ChromeTraceReader::Read(path, trace);
+	if (!loaded)
+		return false;
+
+	capture.Path = path;
+	capture.FrameCount = trace.Frames.size();
+	for (const TraceFile::ScopeRecord& scope : trace.Scopes)
+	{
+		ScopeTimes& times = capture.Scopes[trace.GetName(scope.NameID)];
+		times.Calls++;
+		times.Total += scope.Duration;
+		times.Durations.push_back(scope.Duration);
+	}
+
+	for (auto& [name, times] : capture.Scopes)
+		std::sort(times.Durations.begin(), times.Durations.end());
+	return true;
+}
+
+static int PrintUsage()
+{
+	std::cerr << "Usage: TraceCompare <baseline> <candidate> [--csv <path>] [--json <path>] [--top <count>] [--fail-above <percent>]\n";
+	return 1;
+}
+
+// The whole value has to be a number, "10abc" is rejected
+template<typename T>
+static bool ParseNumber(std::string_view text, T& value)
+{
+	const char* end = text.data() + text.size();
+	auto [last, error] = std::from_chars(text.data(), end, value);
+	return error == std::errc() && last == end;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+		return PrintUsage();
+
+	std::string csvPath, jsonPath;
+	size_t top = 25;
+	double failAbove = -1.0;
+	for (int i = 3; i < argc; i += 2)
+	{
+		const std::string_view option = argv[i];
+		if (i + 1 == argc)
+		{
+			std::cerr << "Option '" << option << "' needs a value.\n";
+			return PrintUsage();
+		}
+
+		const std::string_view value = argv[i + 1];
+		bool valid = true;
+		if (option == "--csv")
+			csvPath = value;
+		else if (option == "--json")
+			jsonPath = value;
+		else if (option == "--top")
+			valid = ParseNumber(value, top);
+		else if (option == "--fail-above")
+			valid = ParseNumber(value, failAbove) && std::isfinite(failAbove) && failAbove >= 0.0;
+		else
+		{
+			std::cerr << "Unknown option '" << option << "'.\n";
+			return PrintUsage();
+		}
+
+		if (!valid)
+		{
+			std::cerr << "Invalid value '" << value << "' for option '" << option << "'.\n";
+			return PrintUsage();
+		}
+	}
+
+	Capture baseline, candidate;
+	for (auto [path, capture] : { std::pair{ argv[1], &baseline }, std::pair{ argv[2], &candidate } })
+	{
+		if (!LoadCapture(path, *capture))
+		{
+			std::cerr << "Could not read capture '" << path << "'.\n";
+			return 1;
+		}
+	}
+
+	// Per frame only makes sense when both captures have frame marks
+	const bool perFrame = baseline.FrameCount && candidate.FrameCount;
+	auto getTime = [&](const ScopeTimes* times, const Capture& capture) { return times ? times->Total / 1e6 / (perFrame ? capture.FrameCount : 1) : 0.0; };
+
+	static const ScopeTimes empty;
+	std::vector<ScopeDelta> deltas;
+	for (const Capture* capture : { &baseline, &candidate })
+	{
+		for (const auto& [name, times] : capture->Scopes)
+		{
+			if (capture == &candidate && baseline.Scopes.contains(name))
+				continue;
+
+			auto baselineIt = baseline.Scopes.find(name);
+			auto candidateIt = candidate.Scopes.find(name);
+			const ScopeTimes* baselineTimes = baselineIt != baseline.Scopes.end() ? &baselineIt->second : nullptr;
+			const ScopeTimes* candidateTimes = candidateIt != candidate.Scopes.end() ? &candidateIt->second : nullptr;
+			deltas.push_back({ name, baselineTimes ? baselineTimes : &empty, candidateTimes ? candidateTimes : &empty, getTime(baselineTimes, baseline), getTime(candidateTimes, candidate) });
+		}
+	}
+
+	std::sort(deltas.begin(), deltas.end(), [](const ScopeDelta& a, const ScopeDelta& b) { return std::abs(a.GetImpact()) > std::abs(b.GetImpact()); });
+
+	const char* unit = perFrame ? "ms/frame" : "ms";
+	std::cout << "Baseline:  " << baseline.Path << " (" << baseline.Scopes.size() << " scopes, " << baseline.FrameCount << " frames)\n";
+	std::cout << "Candidate: " << candidate.Path << " (" << candidate.Scopes.size() << " scopes, " << candidate.FrameCount << " frames)\n\n";
+	std::cout << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < std::min(top, deltas.size()); i++)
+	{
+		const ScopeDelta& delta = deltas[i];
+		std::cout << std::showpos << std::setw(10) << delta.GetImpact() << std::noshowpos << ' ' << unit;
+		std::cout << "  (" << std::setw(8) << delta.BaselineTime << " -> " << std::setw(8) << delta.CandidateTime << ")";
+		std::cout << "  mean " << delta.Baseline->GetMean() / 1e3 << " -> " << delta.Candidate->GetMean() / 1e3 << " us";
+		std::cout << "  p99 " << delta.Baseline->GetPercentile(99.0) / 1e3 << " -> " << delta.Candidate->GetPercentile(99.0) / 1e3 << " us";
+		std::cout << "  calls " << delta.Baseline->Calls << " -> " << delta.Candidate->Calls;
+		std::cout << "  " << delta.Name << "\n";
+	}
+
+	if (!csvPath.empty())
+	{
+		std::ofstream csv(csvPath);
+		csv << std::fixed << std::setprecision(3);
+		csv << "Scope,Impact (" << unit << "),Change (%),Baseline (" << unit << "),Candidate (" << unit << "),Baseline Calls,Candidate Calls,"
+			<< "Baseline Mean (us),Candidate Mean (us),Baseline P50 (us),Candidate P50 (us),Baseline P90 (us),Candidate P90 (us),Baseline P99 (us),Candidate P99 (us)\n";
+		for (const ScopeDelta& delta : deltas)
+		{
+			TraceFile::WriteCsvString(csv, delta.Name);
+			csv << ',' << delta.GetImpact() << ',' << delta.GetChangePercent() << ',' << delta.BaselineTime << ',' << delta.CandidateTime << ',';
+			csv << delta.Baseline->Calls << ',' << delta.Candidate->Calls << ',' << delta.Baseline->GetMean() / 1e3 << ',' << delta.Candidate->GetMean() / 1e3;
+			for (double percentile : { 50.0, 90.0, 99.0 })
+				csv << ',' << delta.Baseline->GetPercentile(percentile) / 1e3 << ',' << delta.Candidate->GetPercentile(percentile) / 1e3;
+			csv << '\n';
+		}
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream json(jsonPath);
+		json << std::fixed << std::setprecision(3);
+		json << "{\"perFrame\":" << (perFrame ? "true" : "false") << ",\"scopes\":[";
+		for (size_t i = 0; i < deltas.size(); i++)
+		{
+			const ScopeDelta& delta = deltas[i];
+			json << (i ? "," : "") << "{\"name\":";
+			TraceFile::WriteJsonString(json, delta.Name);
+			json << ",\"impact\":" << delta.GetImpact() << ",\"changePercent\":" << delta.GetChangePercent();
+			for (auto [key, times, time] : { std::tuple{ "baseline", delta.Baseline, delta.BaselineTime }, std::tuple{ "candidate", delta.Candidate, delta.CandidateTime } })
+			{
+				json << ",\"" << key << "\":{\"time\":" << time << ",\"calls\":" << times->Calls << ",\"mean\":" << times->GetMean() / 1e3;
+				json << ",\"p50\":" << times->GetPercentile(50.0) / 1e3 << ",\"p90\":" << times->GetPercentile(90.0) / 1e3 << ",\"p99\":" << times->GetPercentile(99.0) / 1e3 << "}";
+			}
+			json << "}";
+		}
+		json << "]}\n";
+	}
+
+	// For CI: fail when any scope that exists in both captures got slower by more than the given percentage
+	if (failAbove >= 0.0)
+	{
+		size_t regressions = 0;
+		for (const ScopeDelta& delta : deltas)
+		{
+			if (delta.Baseline->Calls && delta.Candidate->Calls && delta.GetChangePercent() > failAbove)
+			{
+				std::cerr << "Regression: " << delta.Name << " +" << delta.GetChangePercent() << "%\n";
+				regressions++;
+			}
+		}
+		return regressions ? 2 : 0;
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+// Converts a binary Instrumentor session (.mgtrace) into Chrome / Perfetto JSON.
+// Usage: TraceConverter <input.mgtrace> [output.json]
+
+#include "Debugs/TraceFile.h"
+
+#include <filesystem>
+#include <iostream>
+
+using namespace MyGame;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: TraceConverter <input" << TraceFile::BinaryExtension << "> [output.json]\n";
+		return 1;
+	}
+
+	const std::string inputPath = argv[1];
+	const std::string outputPath = argc > 2 ? argv[2] : std::filesystem::path(inputPath).replace_extension(".json").string();
+
+	TraceFile::Trace trace;
+	if (!TraceFile::Read(inputPath, trace))
+	{
+		std::cerr << "Could not read binary trace '" << inputPath << "'.\n";
+		return 1;
+	}
+
+	std::ofstream output(outputPath);
+	if (!output)
+	{
+		std::cerr << "Could not open output file '" << outputPath << "'.\n";
+		return 1;
+	}
+
+	TraceFile::WriteChromeHeader(output);
+	for (const auto& [threadIndex, nameID] : trace.ThreadNames)
+		TraceFile::WriteChromeThreadName(output, trace.GetThreadID(threadIndex), trace.GetName(nameID));
+	for (const TraceFile::FrameRecord& frame : trace.Frames)
+		TraceFile::WriteChromeScope(output, "Frame", trace.GetThreadID(frame.ThreadIndex), frame.Start, frame.Duration);
+	for (const TraceFile::ScopeRecord& scope : trace.Scopes)
+		TraceFile::WriteChromeScope(output, trace.GetName(scope.NameID), trace.GetThreadID(scope.ThreadIndex), scope.Start, scope.Duration);
+	for (const TraceFile::CounterRecord& counter : trace.Counters)
+		TraceFile::WriteChromeCounter(output, trace.GetName(counter.NameID), trace.GetThreadID(counter.ThreadIndex), counter.Timestamp, counter.Value);
+	for (const TraceFile::FlowRecord& flow : trace.Flows)
+		TraceFile::WriteChromeFlow(output, trace.GetName(flow.NameID), flow.Phase, trace.GetThreadID(flow.ThreadIndex), flow.Timestamp, flow.FlowID);
+	for (const TraceFile::Sample& sample : trace.Samples)
+	{
+		std::string stack;
+		for (auto it = sample.Frames.rbegin(); it != sample.Frames.rend(); ++it)
+			stack += (stack.empty() ? "" : ";") + trace.GetName(*it);
+		TraceFile::WriteChromeSample(output, sample.Frames.empty() ? "<unknown>" : trace.GetName(sample.Frames.front()), trace.GetThreadID(sample.ThreadIndex), sample.Timestamp, stack);
+	}
+	if (!trace.Allocations.empty())
+	{
+		const int64_t end = trace.Scopes.empty() ? 0 : trace.Scopes.back().Start + trace.Scopes.back().Duration;
+		for (const TraceFile::AllocationRecord& allocation : trace.Allocations)
+			TraceFile::WriteChromeAllocation(output, trace.GetName(allocation.NameID), allocation.Kind, end, allocation.Count, allocation.Bytes, allocation.LiveBytes, allocation.PeakBytes);
+	}
+	TraceFile::WriteChromeFooter(output);
+
+	std::cout << "Converted session '" << trace.SessionName << "': " << trace.Scopes.size() << " scopes, " << trace.Frames.size() << " frames, " << trace.Counters.size() << " counter samples, " << trace.Flows.size() << " flow events, " << trace.Samples.size() << " samples, " << trace.Names.size() << " names -> " << outputPath << "\n";
+	return 0;
+}